@@ -41,6 +41,7 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 
 #include <itomp_ca_planner/common.h>
 #include <itomp_ca_planner/util/vector_util.h>
+#include <itomp_ca_planner/util/contiguous_array_2d.h>
 #include <kdl/frames.hpp>
 #include <moveit/planning_scene/planning_scene.h>
 
@@ -54,15 +55,16 @@ public:
 	ContactPoint(const std::string& linkName, const ItompRobotModel* robot_model);
 	virtual ~ContactPoint();
 
-	void getPosition(int point, KDL::Vector& position, const std::vector<std::vector<KDL::Frame> >& segmentFrames) const;
-	void getFrame(int point, KDL::Frame& frame, const std::vector<std::vector<KDL::Frame> >& segmentFrames) const;
+	void getPosition(int point, KDL::Vector& position, const ContiguousArray2D<KDL::Frame>& segmentFrames) const;
+	void getFrame(int point, KDL::Frame& frame, const ContiguousArray2D<KDL::Frame>& segmentFrames) const;
 	void updateContactViolationVector(int start, int end, double discretization,
 			std::vector<Vector4d>& contactViolationVector,
 			std::vector<KDL::Vector>& contactPointVelVector,
-            const std::vector<std::vector<KDL::Frame> >& segmentFrames,
+			std::vector<KDL::Vector>& contactPointPosVector,
+            const ContiguousArray2D<KDL::Frame>& segmentFrames,
             const planning_scene::PlanningSceneConstPtr& planning_scene) const;
 
-    double getDistanceToGround(int point, const std::vector<std::vector<KDL::Frame> >& segmentFrames, const planning_scene::PlanningSceneConstPtr& planning_scene) const;
+    double getDistanceToGround(int point, const ContiguousArray2D<KDL::Frame>& segmentFrames, const planning_scene::PlanningSceneConstPtr& planning_scene) const;
 
 	int getLinkSegmentNumber() const { return linkSegmentNumber_; }
 	const std::string& getLinkName() const { return linkName_; }
@@ -0,0 +1,204 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+
+#ifndef SIGNED_DISTANCE_FIELD_H_
+#define SIGNED_DISTANCE_FIELD_H_
+
+#include <itomp_ca_planner/common.h>
+#include <itomp_ca_planner/util/singleton.h>
+#include <itomp_ca_planner/model/itomp_robot_model.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <kdl/frames.hpp>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * Signed distance field of the static world objects of a planning scene,
+ * used as an approximate collision cost backend (use_sdf_collision_cost).
+ * The robot links are approximated by bounding spheres attached to KDL segments.
+ */
+class SignedDistanceField : public Singleton<SignedDistanceField>
+{
+public:
+	struct CollisionSphere
+	{
+		int segment_index_; /**< KDL segment index of the link */
+		KDL::Vector center_; /**< center in the segment frame */
+		double radius_;
+	};
+
+	SignedDistanceField();
+	virtual ~SignedDistanceField();
+
+	/**
+	 * \brief Voxelizes the world of the planning scene and builds the collision spheres of the robot
+	 */
+	void initialize(const planning_scene::PlanningSceneConstPtr& planning_scene,
+	                const ItompRobotModel& robot_model);
+
+	bool isInitialized() const;
+
+	/**
+	 * \brief Trilinearly interpolated signed distance, negative inside obstacles.
+	 *
+	 * Points outside of the grid are at least getMaxDistance() away from any obstacle.
+	 */
+	double getDistance(const KDL::Vector& position) const;
+	/**
+	 * \brief Interpolated signed distance and its gradient by the position, zero outside of the grid
+	 */
+	double getDistance(const KDL::Vector& position, KDL::Vector& gradient) const;
+	double getMaxDistance() const;
+
+	const std::vector<CollisionSphere>& getCollisionSpheres() const;
+
+private:
+	void computeCollisionSpheres(const ItompRobotModel& robot_model);
+	void voxelizeShape(const shapes::Shape* shape, const Eigen::Affine3d& pose,
+	                   std::vector<char>& occupied) const;
+	void computeDistanceTransform(const std::vector<char>& occupied);
+	void computeSquaredDistances(std::vector<float>& grid) const;
+
+	int getIndex(int x, int y, int z) const;
+
+	bool initialized_;
+	double resolution_;
+	double max_distance_; /**< padding of the grid around the obstacles */
+	Eigen::Vector3d origin_; /**< min corner of the grid */
+	int size_[3];
+	std::vector<float> distances_; /**< signed distances of the voxel centers, x-major */
+
+	std::vector<CollisionSphere> collision_spheres_;
+};
+
+/////////////////////////////// inline functions follow ///////////////////////////////////
+
+inline bool SignedDistanceField::isInitialized() const
+{
+	return initialized_;
+}
+
+inline double SignedDistanceField::getMaxDistance() const
+{
+	return max_distance_;
+}
+
+inline const std::vector<SignedDistanceField::CollisionSphere>& SignedDistanceField::getCollisionSpheres() const
+{
+	return collision_spheres_;
+}
+
+inline int SignedDistanceField::getIndex(int x, int y, int z) const
+{
+	return (z * size_[1] + y) * size_[0] + x;
+}
+
+inline double SignedDistanceField::getDistance(const KDL::Vector& position) const
+{
+	// continuous grid coordinates of the voxel centers
+	double gx = (position.x() - origin_.x()) / resolution_ - 0.5;
+	double gy = (position.y() - origin_.y()) / resolution_ - 0.5;
+	double gz = (position.z() - origin_.z()) / resolution_ - 0.5;
+	int x = (int)std::floor(gx);
+	int y = (int)std::floor(gy);
+	int z = (int)std::floor(gz);
+	if (x < 0 || y < 0 || z < 0 || x + 1 >= size_[0] || y + 1 >= size_[1] || z + 1 >= size_[2])
+		return max_distance_;
+
+	double fx = gx - x;
+	double fy = gy - y;
+	double fz = gz - z;
+
+	const float* d = &distances_[getIndex(x, y, z)];
+	int sy = size_[0];
+	int sz = size_[0] * size_[1];
+	double d00 = d[0] + fx * (d[1] - d[0]);
+	double d10 = d[sy] + fx * (d[sy + 1] - d[sy]);
+	double d01 = d[sz] + fx * (d[sz + 1] - d[sz]);
+	double d11 = d[sz + sy] + fx * (d[sz + sy + 1] - d[sz + sy]);
+	double d0 = d00 + fy * (d10 - d00);
+	double d1 = d01 + fy * (d11 - d01);
+	return d0 + fz * (d1 - d0);
+}
+
+inline double SignedDistanceField::getDistance(const KDL::Vector& position, KDL::Vector& gradient) const
+{
+	double gx = (position.x() - origin_.x()) / resolution_ - 0.5;
+	double gy = (position.y() - origin_.y()) / resolution_ - 0.5;
+	double gz = (position.z() - origin_.z()) / resolution_ - 0.5;
+	int x = (int)std::floor(gx);
+	int y = (int)std::floor(gy);
+	int z = (int)std::floor(gz);
+	if (x < 0 || y < 0 || z < 0 || x + 1 >= size_[0] || y + 1 >= size_[1] || z + 1 >= size_[2])
+	{
+		gradient = KDL::Vector::Zero();
+		return max_distance_;
+	}
+
+	double fx = gx - x;
+	double fy = gy - y;
+	double fz = gz - z;
+
+	const float* d = &distances_[getIndex(x, y, z)];
+	int sy = size_[0];
+	int sz = size_[0] * size_[1];
+
+	// differences along x of the four cell edges, interpolated like the distance
+	double ex00 = d[1] - d[0];
+	double ex10 = d[sy + 1] - d[sy];
+	double ex01 = d[sz + 1] - d[sz];
+	double ex11 = d[sz + sy + 1] - d[sz + sy];
+	double d00 = d[0] + fx * ex00;
+	double d10 = d[sy] + fx * ex10;
+	double d01 = d[sz] + fx * ex01;
+	double d11 = d[sz + sy] + fx * ex11;
+	double ex0 = ex00 + fy * (ex10 - ex00);
+	double ex1 = ex01 + fy * (ex11 - ex01);
+	double d0 = d00 + fy * (d10 - d00);
+	double d1 = d01 + fy * (d11 - d01);
+
+	gradient.x((ex0 + fz * (ex1 - ex0)) / resolution_);
+	gradient.y(((d10 - d00) + fz * ((d11 - d01) - (d10 - d00))) / resolution_);
+	gradient.z((d1 - d0) / resolution_);
+	return d0 + fz * (d1 - d0);
+}
+
+}
+
+#endif /* SIGNED_DISTANCE_FIELD_H_ */
@@ -41,6 +41,7 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 
 #include <itomp_ca_planner/common.h>
 #include <itomp_ca_planner/trajectory/itomp_cio_trajectory.h>
+#include <itomp_ca_planner/cost/smoothness_cost_cache.h>
 
 namespace itomp_ca_planner
 {
@@ -52,43 +53,64 @@ public:
       double ridge_factor = 0.0);
   virtual ~SmoothnessCost();
 
-  const Eigen::MatrixXd& getQuadraticCostInverse() const;
-  const Eigen::MatrixXd& getQuadraticCost() const;
+  // the unscaled lower band of the quadratic cost, shared through SmoothnessCostCache
+  const Eigen::MatrixXd& getQuadraticCostBand() const;
+  double getScale() const;
 
   double getCost(Eigen::MatrixXd::ColXpr joint_trajectory) const;
   double getCost(Eigen::MatrixXd::ConstColXpr joint_trajectory) const;
 
+  // adds weight * d(cost)/d(point) of the points [begin, begin + gradient.size())
+  void addGradient(const Eigen::Ref<const Eigen::VectorXd>& joint_trajectory, int begin, double weight,
+      Eigen::Ref<Eigen::VectorXd> gradient) const;
+
   double getMaxQuadCostInvValue() const;
 
   void scale(double scale);
 
 private:
-  Eigen::MatrixXd quad_cost_full_;
-  Eigen::MatrixXd quad_cost_;
-  Eigen::MatrixXd quad_cost_inv_;
+  double computeCost(const Eigen::Ref<const Eigen::VectorXd>& joint_trajectory) const;
 
-  Eigen::MatrixXd getDiffMatrix(int size, const double* diff_rule) const;
+  SmoothnessCostCache::JointCostConstPtr joint_cost_;
+  double scale_;
 
 };
 
-inline const Eigen::MatrixXd& SmoothnessCost::getQuadraticCostInverse() const
+inline const Eigen::MatrixXd& SmoothnessCost::getQuadraticCostBand() const
 {
-  return quad_cost_inv_;
+  return joint_cost_->quad_cost_band_;
 }
 
-inline const Eigen::MatrixXd& SmoothnessCost::getQuadraticCost() const
+inline double SmoothnessCost::getScale() const
 {
-  return quad_cost_;
+  return scale_;
 }
 
 inline double SmoothnessCost::getCost(Eigen::MatrixXd::ColXpr joint_trajectory) const
 {
-  return joint_trajectory.dot(quad_cost_full_ * joint_trajectory);
+  return computeCost(joint_trajectory);
 }
 
 inline double SmoothnessCost::getCost(Eigen::MatrixXd::ConstColXpr joint_trajectory) const
 {
-  return joint_trajectory.dot(quad_cost_full_ * joint_trajectory);
+  return computeCost(joint_trajectory);
+}
+
+inline double SmoothnessCost::computeCost(const Eigen::Ref<const Eigen::VectorXd>& joint_trajectory) const
+{
+  // x^T A x with the band stencil, each off-diagonal term counts twice
+  const Eigen::MatrixXd& band = joint_cost_->quad_cost_band_;
+  const int num_points = band.cols();
+  const int bandwidth = band.rows() - 1;
+  double cost = 0.0;
+  for (int j = 0; j < num_points; ++j)
+  {
+    double row = band(0, j) * joint_trajectory(j);
+    for (int k = 1; k <= bandwidth && j + k < num_points; ++k)
+      row += 2.0 * band(k, j) * joint_trajectory(j + k);
+    cost += joint_trajectory(j) * row;
+  }
+  return scale_ * cost;
 }
 
 }
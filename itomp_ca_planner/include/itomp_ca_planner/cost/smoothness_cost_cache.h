@@ -0,0 +1,111 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+
+#ifndef SMOOTHNESS_COST_CACHE_H_
+#define SMOOTHNESS_COST_CACHE_H_
+
+#include <itomp_ca_planner/common.h>
+#include <itomp_ca_planner/util/banded_cholesky.h>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Process-wide cache of the smoothness cost matrices and their factorizations
+ *
+ * The entries only depend on the number of points, the discretization, the derivative
+ * costs and the ridge factor, so they are built once and shared (immutable) by every
+ * optimizer thread and planning request. All methods are thread-safe.
+ * Each map is flushed when it holds MAX_ENTRIES entries; the entries in use stay alive
+ * through their shared pointers.
+ */
+class SmoothnessCostCache
+{
+public:
+  // quadratic cost of a joint trajectory, used by SmoothnessCost
+  struct JointCost
+  {
+    Eigen::MatrixXd quad_cost_band_; /**< DIFF_RULE_LENGTH x num_points lower band of the symmetric cost */
+    double max_quad_cost_inv_value_; /**< max coefficient of the inverse of the free variable block */
+  };
+
+  // control cost of the free variables, used by ImprovementManagerChomp
+  struct ControlCost
+  {
+    BandedCholesky cholesky_; /**< factored control cost of the free variables */
+    Eigen::VectorXd projection_scales_; /**< column scales of the smooth noise projection, empty if unused */
+  };
+
+  static const unsigned int MAX_ENTRIES = 16;
+
+  typedef boost::shared_ptr<const JointCost> JointCostConstPtr;
+  typedef boost::shared_ptr<const ControlCost> ControlCostConstPtr;
+
+  static SmoothnessCostCache& getInstance()
+  {
+    return instance_;
+  }
+
+  JointCostConstPtr getJointCost(int num_points, double discretization, const std::vector<double>& derivative_costs,
+      double ridge_factor);
+  ControlCostConstPtr getControlCost(int num_vars_free, double discretization,
+      const std::vector<double>& derivative_costs, double ridge_factor, bool projection);
+
+  void clear();
+
+private:
+  SmoothnessCostCache();
+
+  static JointCostConstPtr buildJointCost(int num_points, double discretization,
+      const std::vector<double>& derivative_costs, double ridge_factor);
+  static ControlCostConstPtr buildControlCost(int num_vars_free, double discretization,
+      const std::vector<double>& derivative_costs, double ridge_factor, bool projection);
+
+  static std::vector<double> makeKey(int size, double discretization, const std::vector<double>& derivative_costs,
+      double ridge_factor);
+
+  boost::mutex mtx_;
+  std::map<std::vector<double>, JointCostConstPtr> joint_costs_;
+  std::map<std::vector<double>, ControlCostConstPtr> control_costs_;
+
+  static SmoothnessCostCache instance_;
+};
+
+}
+
+#endif
@@ -75,10 +75,12 @@ public:
 
   virtual void init(const EvaluationData* data);
 
-  void compute(const EvaluationData* data, Eigen::VectorXd& costData, double& sum);
-  virtual double getWaypointCost(int waypoint, const Eigen::VectorXd& costData) const
+  // writes the cost of each point to costData, a column of the cost matrix of the accumulator
+  void compute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
+  // whether the cost data is also a per-waypoint cost (otherwise it only adds to the trajectory cost)
+  virtual bool hasWaypointCosts() const
   {
-    return costData(waypoint);
+    return true;
   }
   bool getIsHardConstraint() const
   {
@@ -97,8 +99,7 @@ public:
   static boost::shared_ptr<TrajectoryCost> CreateTrajectoryCost(COST_TYPE type);
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData) = 0;
-  void computeCostSum(const EvaluationData* data, Eigen::VectorXd& costData, double& sum);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData) = 0;
 
   bool isHardConstraint_;
   COST_TYPE type_;
@@ -118,14 +119,14 @@ public:
   {
   }
 
-  virtual double getWaypointCost(int waypoint, const Eigen::VectorXd& costData) const
+  virtual bool hasWaypointCosts() const
   {
-    return 0.0;
+    return false;
   }
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectoryCollisionCost: public TrajectoryCost
@@ -142,7 +143,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectoryValidityCost: public TrajectoryCost
@@ -159,7 +160,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectoryContactInvariantCost: public TrajectoryCost
@@ -176,7 +177,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectoryPhysicsViolationCost: public TrajectoryCost
@@ -193,7 +194,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectoryGoalPoseCost: public TrajectoryCost
@@ -210,7 +211,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectoryCoMCost: public TrajectoryCost
@@ -227,7 +228,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectoryFTRCost: public TrajectoryCost
@@ -244,7 +245,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectoryCartesianCost: public TrajectoryCost
@@ -261,7 +262,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 class TrajectorySingularityCost: public TrajectoryCost
@@ -278,7 +279,7 @@ public:
   virtual double getWeight() const;
 
 protected:
-  virtual void doCompute(const EvaluationData* data, Eigen::VectorXd& costData);
+  virtual void doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData);
 };
 
 }
@@ -58,6 +58,7 @@ public:
 
 	double getWaypointCost(int waypoint) const;
 	double getWaypointCost(int waypoint, TrajectoryCost::COST_TYPE type) const;
+	void getWaypointCosts(int start, int num_waypoints, Eigen::VectorXd& costs) const;
 	double getTrajectoryCost(TrajectoryCost::COST_TYPE type) const;
 	double getTrajectoryCost() const;
 
@@ -66,9 +67,12 @@ public:
 	void print(int number) const;
 
 protected:
-	std::map<TrajectoryCost::COST_TYPE, TrajectoryCostPtr> costMap_;
-	std::map<TrajectoryCost::COST_TYPE, Eigen::VectorXd> costDataMap_;
-	std::map<TrajectoryCost::COST_TYPE, double> costSumMap_;
+	std::vector<TrajectoryCostPtr> costs_; /**< indexed by COST_TYPE, NULL if not added */
+	std::vector<int> activeCostTypes_; /**< added costs with a non-zero weight */
+	Eigen::MatrixXd costData_; /**< [point][cost type], column-major so each cost writes a contiguous column */
+	Eigen::VectorXd costSums_; /**< sum of the costs of the points 1 .. num_points - 2 of each cost type */
+	Eigen::VectorXd weights_; /**< weight of each cost type, 0 for the inactive ones */
+	Eigen::VectorXd waypointWeights_; /**< weights_ without the costs which have no per-waypoint cost */
 
 	mutable double best_cost_;
 
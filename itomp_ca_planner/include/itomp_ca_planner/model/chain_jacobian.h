@@ -0,0 +1,115 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+
+#ifndef CHAIN_JACOBIAN_H_
+#define CHAIN_JACOBIAN_H_
+
+#include <itomp_ca_planner/common.h>
+#include <itomp_ca_planner/model/treefksolverjointposaxis_partial.hpp>
+#include <kdl/frames.hpp>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Geometric jacobian of a segment origin w.r.t. a set of joints
+ *
+ * Computed from the joint positions, joint axes and segment frames of one
+ * waypoint of forward kinematics, in the FK reference frame. Holds no scratch,
+ * so one instance can be used by several threads.
+ */
+class ChainJacobian
+{
+public:
+	ChainJacobian();
+
+	/**
+	 * \brief Sets up the jacobian of the segment w.r.t. the given KDL joints
+	 *
+	 * Joints which do not move the segment get zero columns.
+	 * \return false if the segment is not in the tree
+	 */
+	bool init(const KDL::TreeFkSolverJointPosAxisPartial& fk_solver, int segment,
+			const std::vector<int>& kdl_joints);
+
+	bool isValid() const;
+	int getSegment() const;
+	int getNumColumns() const;
+
+	// 6 x n jacobian, linear velocity rows first
+	void compute(const KDL::Vector* joint_pos, const KDL::Vector* joint_axis,
+			const KDL::Frame* segment_frames, Eigen::MatrixXd& jacobian) const;
+	// 3 x n linear velocity part
+	void computePosition(const KDL::Vector* joint_pos, const KDL::Vector* joint_axis,
+			const KDL::Frame* segment_frames, Eigen::MatrixXd& jacobian) const;
+	// d^T (J_p J_p^T) d == |J_p^T d|^2, without forming J_p
+	double computeDirectionalManipulability(const KDL::Vector* joint_pos,
+			const KDL::Vector* joint_axis, const KDL::Frame* segment_frames,
+			const KDL::Vector& direction) const;
+	// sqrt(det(J J^T)) from a Cholesky factorization, sqrt(det(J^T J)) with fewer than 6 joints.
+	// jacobian is scratch. Returns 0 at a singularity.
+	double computeManipulability(const KDL::Vector* joint_pos, const KDL::Vector* joint_axis,
+			const KDL::Frame* segment_frames, Eigen::MatrixXd& jacobian) const;
+
+private:
+	int segment_; /**< KDL segment number, -1 if not initialized */
+	int num_columns_; /**< Number of joints given to init() */
+	std::vector<int> joints_; /**< KDL numbers of the joints moving the segment */
+	std::vector<int> columns_; /**< Jacobian column of each of joints_ */
+	std::vector<bool> translational_; /**< Whether each of joints_ is prismatic */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline bool ChainJacobian::isValid() const
+{
+	return segment_ != -1;
+}
+
+inline int ChainJacobian::getSegment() const
+{
+	return segment_;
+}
+
+inline int ChainJacobian::getNumColumns() const
+{
+	return num_columns_;
+}
+
+}
+#endif
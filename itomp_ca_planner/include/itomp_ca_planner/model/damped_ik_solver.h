@@ -0,0 +1,92 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+
+#ifndef DAMPED_IK_SOLVER_H_
+#define DAMPED_IK_SOLVER_H_
+
+#include <itomp_ca_planner/common.h>
+#include <itomp_ca_planner/model/itomp_planning_group.h>
+#include <kdl/frames.hpp>
+#include <kdl/jntarray.hpp>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Damped least-squares IK of the last link of a planning group
+ *
+ * Uses the group forward kinematics and ChainJacobian, so the target link is the
+ * one RobotState::setFromIK uses for the group. Holds its own FK solver and scratch,
+ * so each thread needs its own instance.
+ */
+class DampedIkSolver
+{
+public:
+	DampedIkSolver(const ItompPlanningGroup* planning_group);
+
+	/**
+	 * \brief Moves the group joints of q, the values of all KDL joints, towards the target frame
+	 *
+	 * q is used as the initial guess. Joints with limits are kept inside them.
+	 * \return true if the target was reached within the tolerances
+	 */
+	bool solve(const KDL::Frame& target, KDL::JntArray& q);
+
+	/**
+	 * \brief Solves a sequence of waypoints, each seeded from the solution of the previous one
+	 *
+	 * The waypoints are solved in order on the calling thread.
+	 * \param seed values of all KDL joints before the first waypoint
+	 * \param solutions [waypoint][KDL joint] values
+	 * \param converged whether each waypoint reached its target
+	 * \return the number of converged waypoints
+	 */
+	static int solvePath(const ItompPlanningGroup* planning_group, const std::vector<KDL::Frame>& targets,
+			const KDL::JntArray& seed, Eigen::MatrixXd& solutions, std::vector<bool>& converged);
+
+private:
+	const ItompPlanningGroup* planning_group_;
+	KDL::TreeFkSolverJointPosAxisPartial fk_solver_; /**< own copy, KDL::Joint::pose() caches its last result */
+	std::vector<KDL::Vector> joint_pos_;
+	std::vector<KDL::Vector> joint_axis_;
+	std::vector<KDL::Frame> segment_frames_;
+	Eigen::MatrixXd jacobian_;
+};
+
+}
+#endif
@@ -0,0 +1,74 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+
+#ifndef GENERATED_FK_H_
+#define GENERATED_FK_H_
+
+#include <itomp_ca_planner/model/treefksolverjointposaxis_partial.hpp>
+#include <string>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Unrolled forward kinematics of a fixed robot, emitted by scripts/generate_fk.py
+ * The outputs follow KDL::TreeFkSolverJointPosAxisPartial::JntToCartFull
+ */
+struct GeneratedFk
+{
+	const char* robot_name_; /**< name of the robot in the URDF */
+	int num_joints_;
+	int num_segments_;
+	const char* const* segment_names_; /**< segment names in the order of the KDL tree */
+	KDL::TreeFkSolverJointPosAxisPartial::UnrolledFk function_;
+	GeneratedFk* next_;
+};
+
+// the generated sources register themselves with a static registrar
+class GeneratedFkRegistrar
+{
+public:
+	GeneratedFkRegistrar(GeneratedFk* fk);
+};
+
+// returns NULL if no function was generated for the robot
+const GeneratedFk* findGeneratedFk(const std::string& robot_name);
+
+}
+
+#endif
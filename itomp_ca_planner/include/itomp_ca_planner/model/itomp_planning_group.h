@@ -43,7 +43,10 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <kdl/tree.hpp>
 #include <itomp_ca_planner/model/itomp_robot_joint.h>
 #include <itomp_ca_planner/model/treefksolverjointposaxis_partial.hpp>
+#include <itomp_ca_planner/model/treefksolverjointposaxis_batch.hpp>
+#include <itomp_ca_planner/model/chain_jacobian.h>
 #include <itomp_ca_planner/contact/contact_point.h>
+#include <moveit/robot_model/robot_model.h>
 
 namespace itomp_ca_planner
 {
@@ -57,7 +60,11 @@ public:
 	std::vector<std::string> link_names_; /**< Links used in planning */
 	std::vector<std::string> collision_link_names_; /**< Links used in collision checking */
 	boost::shared_ptr<KDL::TreeFkSolverJointPosAxisPartial> fk_solver_; /**< Forward kinematics solver for the group */
+	boost::shared_ptr<KDL::TreeFkSolverJointPosAxisBatch> batch_fk_solver_; /**< Forward kinematics of several waypoints at once */
+	const robot_model::JointModelGroup* joint_model_group_; /**< MoveIt group of the same name, NULL for unified_body */
+	ChainJacobian jacobian_; /**< Jacobian of the last link of the group w.r.t. the group joints */
 	std::vector<ContactPoint> contactPoints_;
+	std::vector<ChainJacobian> contact_jacobians_; /**< Jacobian of the group moving each contact point, invalid if none */
 	std::map<int, int> kdl_to_group_joint_;
 
 	std::vector<std::string> getJointNames() const;
@@ -43,6 +43,7 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <itomp_ca_planner/model/itomp_robot_joint.h>
 #include <itomp_ca_planner/model/treefksolverjointposaxis.hpp>
 #include <itomp_ca_planner/model/treefksolverjointposaxis_partial.hpp>
+#include <itomp_ca_planner/model/generated_fk.h>
 #include <kdl/tree.hpp>
 #include <kdl/chain.hpp>
 #include <boost/shared_ptr.hpp>
@@ -101,6 +102,13 @@ public:
 
 	const KDL::TreeFkSolverJointPosAxis* getForwardKinematicsSolver() const;
 
+	/**
+	 * \brief Gets the KDL segment number from the segment name
+	 *
+	 * \return -1 if the segment name is not found
+	 */
+	int getSegmentIndex(const std::string& segment_name) const;
+
 	const std::string& getReferenceFrame() const;
 
 	void jointStateToArray(const sensor_msgs::JointState &joint_state, KDL::JntArray& joint_array);
@@ -118,6 +126,10 @@ public:
 			const std::string& group_name) const;
 
 private:
+	bool validateGeneratedFk(const GeneratedFk& generated_fk) const;
+	void addContactPoint(const std::string& group_name, const std::string& link_name,
+			const std::string& contact_group_name);
+
 	robot_model::RobotModelPtr robot_model_;
 
 	KDL::Tree kdl_tree_; /**< The KDL tree of the entire robot */
@@ -179,6 +191,11 @@ inline const KDL::TreeFkSolverJointPosAxis* ItompRobotModel::getForwardKinematic
 	return fk_solver_;
 }
 
+inline int ItompRobotModel::getSegmentIndex(const std::string& segment_name) const
+{
+	return fk_solver_->segmentNameToIndex(segment_name);
+}
+
 inline const std::string& ItompRobotModel::getReferenceFrame() const
 {
 	return reference_frame_;
@@ -58,9 +58,10 @@ public:
 					std::vector<Frame>& segment_frames) const;
 
 	const std::vector<std::string> getSegmentNames() const;
-	const std::map<std::string, int> getSegmentNameToIndex() const;
+	const std::map<std::string, int>& getSegmentNameToIndex() const;
 
-	int segmentNameToIndex(std::string name) const;
+	// returns -1 if the segment is not in the tree
+	int segmentNameToIndex(const std::string& name) const;
 
 private:
 	int treeRecursiveFK(const JntArray& q_in, std::vector<Vector>& joint_pos,
@@ -0,0 +1,113 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+
+#ifndef KDLTREEFKSOLVERJOINTPOSAXIS_BATCH_HPP
+#define KDLTREEFKSOLVERJOINTPOSAXIS_BATCH_HPP
+
+#include <kdl/tree.hpp>
+#include <kdl/jntarray.hpp>
+#include <vector>
+
+namespace KDL
+{
+
+/**
+ * \brief Forward kinematics of several configurations at once, one configuration per vector lane.
+ * Returns the same joint positions, joint axes and segment frames as TreeFkSolverJointPosAxisPartial::JntToCartFull,
+ * up to rounding. An AVX2 kernel is selected at runtime if the CPU supports it.
+ * JntToCartFullFloat computes in single precision, twice as many configurations per register.
+ */
+class TreeFkSolverJointPosAxisBatch
+{
+public:
+	static const int BATCH_SIZE = 4;
+	static const int FLOAT_BATCH_SIZE = 8;
+
+	TreeFkSolverJointPosAxisBatch();
+	TreeFkSolverJointPosAxisBatch(const Tree& tree, const std::string& reference_frame);
+	~TreeFkSolverJointPosAxisBatch();
+
+	// false if the tree has a joint type the kernel does not handle or the reference frame is not the world
+	bool isSupported() const { return supported_; }
+	bool usesAVX2() const { return use_avx2_; }
+	// false selects the generic kernel. returns false if AVX2 is requested but the CPU does not support it
+	bool setUseAVX2(bool use_avx2);
+
+	// computes q_in[0 .. num_points - 1] (num_points <= BATCH_SIZE), the outputs are the rows of each point.
+	// not thread-safe, each thread has to use its own copy of the solver
+	void JntToCartFull(const JntArray* q_in, int num_points, Vector* const* joint_pos,
+			Vector* const* joint_axis, Frame* const* segment_frames) const;
+	// same with num_points <= FLOAT_BATCH_SIZE, computed in float
+	void JntToCartFullFloat(const JntArray* q_in, int num_points, Vector* const* joint_pos,
+			Vector* const* joint_axis, Frame* const* segment_frames) const;
+
+	enum SegmentType
+	{
+		SEGMENT_FIXED = 0, SEGMENT_ROTATIONAL, SEGMENT_TRANSLATIONAL,
+	};
+
+	// flat tables read by the kernels, in depth-first segment order
+	struct Tables
+	{
+		int num_segments_;
+		int num_joints_;
+		std::vector<int> parent_nr_; /**< parent segment number, -1 for the root */
+		std::vector<int> q_nr_; /**< joint number, -1 for fixed joints */
+		std::vector<int> type_; /**< SegmentType */
+		std::vector<double> pose0_; /**< [segment][12] segment pose at the zero joint value, rotation row-major then position */
+		std::vector<double> joint_axis_; /**< [joint][3] joint axis in the parent frame */
+		std::vector<double> joint_origin_; /**< [joint][3] joint origin in the parent frame */
+	};
+
+private:
+	void buildTables(const SegmentMap::const_iterator this_segment, int parent_nr,
+			const std::string& reference_frame, int& reference_nr);
+
+	Tables tables_;
+	bool supported_;
+	bool use_avx2_;
+
+	mutable std::vector<double> q_lanes_; /**< [joint][BATCH_SIZE] */
+	mutable std::vector<double> frame_lanes_; /**< [segment][12][BATCH_SIZE] */
+	mutable std::vector<float> q_lanes_float_; /**< [joint][FLOAT_BATCH_SIZE] */
+	mutable std::vector<float> frame_lanes_float_; /**< [segment][12][FLOAT_BATCH_SIZE] */
+};
+
+} // namespace KDL
+
+#endif
@@ -52,35 +52,55 @@ class TreeFkSolverJointPosAxisPartial
 
 {
 public:
-  TreeFkSolverJointPosAxisPartial() {}
+	// unrolled FK of the whole tree, with the outputs of JntToCartFull
+	typedef void (*UnrolledFk)(const double* q, Vector* joint_pos, Vector* joint_axis,
+			Frame* segment_frames);
+
+  TreeFkSolverJointPosAxisPartial() : unrolled_fk_(NULL) {}
 	TreeFkSolverJointPosAxisPartial(const Tree& tree,
 			const std::string& reference_frame,
 			const std::vector<bool>& active_joints);
 	~TreeFkSolverJointPosAxisPartial();
 
+	// not reentrant: partial FK writes segment_dirty_ and KDL::Joint::pose() caches its last result,
+	// so each thread has to use its own copy of the solver
 	int
 			JntToCartFull(const JntArray& q_in, std::vector<Vector>& joint_pos,
 					std::vector<Vector>& joint_axis,
-					std::vector<Frame>& segment_frames);
+					std::vector<Frame>& segment_frames) const;
+	// recomputes only the segments below the joints whose values differ from q_cached, the values
+	// the frames were computed with (NaN if unknown). Falls back to JntToCartFull when needed.
 	int
-			JntToCartPartial(const JntArray& q_in,
+			JntToCartPartial(const JntArray& q_in, const double* q_cached,
 					std::vector<Vector>& joint_pos,
 					std::vector<Vector>& joint_axis,
 					std::vector<Frame>& segment_frames) const;
 
+	// versions writing into caller-provided buffers of getNumJoints() / getNumSegments() elements
+	int
+			JntToCartFull(const JntArray& q_in, Vector* joint_pos,
+					Vector* joint_axis, Frame* segment_frames) const;
+	int
+			JntToCartPartial(const JntArray& q_in, const double* q_cached,
+					Vector* joint_pos, Vector* joint_axis,
+					Frame* segment_frames) const;
+
 	const std::vector<std::string> getSegmentNames() const;
-	const std::map<std::string, int> getSegmentNameToIndex() const;
+	const std::map<std::string, int>& getSegmentNameToIndex() const;
 
-	int segmentNameToIndex(std::string name) const;
+	// returns -1 if the segment is not in the tree
+	int segmentNameToIndex(const std::string& name) const;
 	int getNumSegments() const { return num_segments_; }
+	int getNumJoints() const { return num_joints_; }
 
-private:
-	int treeRecursiveFK(const JntArray& q_in, std::vector<Vector>& joint_pos,
-			std::vector<Vector>& joint_axis,
-			std::vector<Frame>& segment_frames, const Frame& previous_frame,
-			const SegmentMap::const_iterator this_segment, int segment_nr,
-			int parent_segment_nr, bool active);
+	// joints moving the segment, ordered from the segment to the root
+	void getAncestorJoints(int segment_nr, std::vector<int>& joint_nrs) const;
+	bool isTranslationalJoint(int joint_nr) const { return joint_translational_[joint_nr]; }
 
+	// makes JntToCartFull use the given function, only possible in the world frame
+	bool setUnrolledFk(UnrolledFk unrolled_fk);
+
+private:
 	std::vector<std::string> segment_names_;
 	std::map<std::string, int> segment_name_to_index_;
 	Tree tree_;
@@ -89,17 +109,25 @@ private:
 	int num_joints_;
 	int num_segments_;
 
-	std::vector<Frame> segment_frames_; /**< local cache of all segment frames needed for partial FK */
 	std::vector<int> segment_evaluation_order_; /**< what order should we evaluate segments in */
 	std::vector<int> segment_parent_frame_nr_; /**< the parent frame number for each segment */
-	std::vector<const TreeElement*> segment_parent_; /**< the parent segment for each segment */
+	std::vector<Segment> segments_; /**< the KDL segment for each segment number */
+	std::vector<int> segment_q_nr_; /**< the joint number of each segment, -1 for fixed joints */
+	std::vector<Frame> segment_fixed_pose_; /**< pose of each segment with a fixed joint */
 	std::vector<int> joint_parent_frame_nr_; /**< the parent frame number for each joint */
-	std::vector<const TreeElement*> joint_parent_; /**< the parent segment for each joint */
+	std::vector<int> joint_segment_nr_; /**< the segment number of each joint */
+	std::vector<Vector> joint_origin_; /**< joint origin in the parent frame for each joint */
+	std::vector<Vector> joint_local_axis_; /**< joint axis in the parent frame for each joint */
 	std::vector<bool> active_joints_; /**< which are the joints that will change in calls to partial FK */
-	std::vector<bool> joint_calc_pos_axis_; /**< which joints should we calculate the position and axis for */
+	bool world_is_reference_frame_; /**< the reference frame is fixed at the identity, needed for partial FK */
+	mutable std::vector<char> segment_dirty_; /**< scratch of partial FK, segments recomputed in this call */
+	std::vector<bool> joint_translational_; /**< whether each joint is prismatic */
+	UnrolledFk unrolled_fk_; /**< generated FK used by JntToCartFull instead of the segment tables, NULL if none */
 
 private:
 	void assignSegmentNumber(const SegmentMap::const_iterator this_segment);
+	int buildSegmentTables(const SegmentMap::const_iterator this_segment,
+			int segment_nr, int parent_segment_nr, bool active);
 
 };
 
@@ -44,6 +44,8 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <itomp_ca_planner/cost/smoothness_cost.h>
 #include <itomp_ca_planner/cost/trajectory_cost_accumulator.h>
 #include <itomp_ca_planner/util/vector_util.h>
+#include <itomp_ca_planner/util/contiguous_array_2d.h>
+#include <itomp_ca_planner/util/undo_journal.h>
 #include <kdl/frames.hpp>
 #include <kdl/jntarray.hpp>
 #include <Eigen/StdVector>
@@ -81,9 +83,11 @@ public:
 
   std::vector<itomp_ca_planner::SmoothnessCost> joint_costs_;
 
-  std::vector<std::vector<KDL::Vector> > joint_axis_;
-  std::vector<std::vector<KDL::Vector> > joint_pos_;
-  std::vector<std::vector<KDL::Frame> > segment_frames_;
+  // [point][joint] / [point][segment]
+  ContiguousArray2D<KDL::Vector> joint_axis_;
+  ContiguousArray2D<KDL::Vector> joint_pos_;
+  ContiguousArray2D<KDL::Frame> segment_frames_;
+  ContiguousArray2D<double> fk_joint_values_; /**< [point][kdl joint] values the frames were computed with, NaN if unknown */
 
   std::vector<int> state_is_in_collision_;
   std::vector<int> state_validity_;
@@ -92,16 +96,18 @@ public:
 
   // physics
   std::vector<KDL::Wrench> wrenchSum_;
-  std::vector<std::vector<KDL::Vector> > linkPositions_;
-  std::vector<std::vector<KDL::Vector> > linkVelocities_;
-  std::vector<std::vector<KDL::Vector> > linkAngularVelocities_;
+  // [mass segment][point]
+  ContiguousArray2D<KDL::Vector> linkPositions_;
+  ContiguousArray2D<KDL::Vector> linkVelocities_;
+  ContiguousArray2D<KDL::Vector> linkAngularVelocities_;
   std::vector<KDL::Vector> CoMPositions_;
   std::vector<KDL::Vector> CoMVelocities_;
   std::vector<KDL::Vector> CoMAccelerations_;
   std::vector<KDL::Vector> AngularMomentums_;
   std::vector<KDL::Vector> Torques_;
-  std::vector<std::vector<Vector4d> > contactViolationVector_;
-  std::vector<std::vector<KDL::Vector> > contactPointVelVector_;
+  // [contact][point]
+  ContiguousArray2D<Vector4d> contactViolationVector_;
+  ContiguousArray2D<KDL::Vector> contactPointVelVector_;
 
   std::vector<double> stateContactInvariantCost_;
   std::vector<double> statePhysicsViolationCost_;
@@ -110,7 +116,8 @@ public:
   std::vector<double> stateCartesianTrajectoryCost_;
   std::vector<double> stateSingularityCost_;
 
-  std::vector<std::vector<KDL::Vector> > contact_forces_;
+  // [point][contact]
+  ContiguousArray2D<KDL::Vector> contact_forces_;
 
   TrajectoryCostAccumulator costAccumulator_;
 
@@ -120,10 +127,36 @@ public:
   planning_scene::PlanningSceneConstPtr planning_scene_;
   std::vector<robot_state::RobotStatePtr> kinematic_state_;
 
+  // buffers reused by every evaluation to avoid heap allocations, one per kinematic_state_
+  struct ThreadScratch
+  {
+    std::vector<double> positions_;
+    std::vector<KDL::Vector> contact_point_positions_;
+    collision_detection::CollisionResult collision_result_;
+    Eigen::MatrixXd jacobian_;
+    KDL::TreeFkSolverJointPosAxisPartial fk_solver_; /**< own copy, KDL::Joint::pose() caches its last result */
+    KDL::JntArray kdl_joint_array_;
+    KDL::TreeFkSolverJointPosAxisBatch batch_fk_solver_; /**< own copy, the lane buffers are mutable */
+    std::vector<KDL::JntArray> batch_joint_arrays_;
+  };
+  std::vector<ThreadScratch> thread_scratch_;
+
+  // [contact][point]
+  ContiguousArray2D<double> contact_ftr_costs_;
+
+  // old contents of the buffers overwritten by a derivative evaluation
+  UndoJournal journal_;
+
   std::vector<KDL::Frame> cartesian_waypoints_;
 
+  // trajectory which the frames and the state costs were computed for (used in incremental evaluation)
+  Eigen::MatrixXd evaluated_group_trajectory_;
+  Eigen::MatrixXd evaluated_contact_trajectory_;
+  bool has_evaluated_trajectory_;
+
   EvaluationData* clone() const;
   void deepCopy(const EvaluationData& data);
+  void allocateOwnTrajectories();
 
   void compare(const EvaluationData& ref) const;
 
@@ -134,6 +167,9 @@ protected:
 
   ItompCIOTrajectory* group_trajectory_;
   ItompCIOTrajectory* full_trajectory_;
+
+  boost::shared_ptr<ItompCIOTrajectory> own_group_trajectory_; /**< set if the group trajectory is owned by this data */
+  boost::shared_ptr<ItompCIOTrajectory> own_full_trajectory_; /**< set if the full trajectory is owned by this data */
 };
 typedef boost::shared_ptr<EvaluationData> EvaluationDataPtr;
 
@@ -44,6 +44,7 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <itomp_ca_planner/trajectory/itomp_cio_trajectory.h>
 #include <itomp_ca_planner/cost/smoothness_cost.h>
 #include <itomp_ca_planner/cost/trajectory_cost_accumulator.h>
+#include <itomp_ca_planner/util/collision_cache.h>
 #include <kdl/frames.hpp>
 #include <kdl/jntarray.hpp>
 #include <ros/publisher.h>
@@ -54,31 +55,6 @@ namespace itomp_ca_planner
 class ItompPlanningGroup;
 class EvaluationManager
 {
-        class BackupData
-        {
-        public:
-                double trajectory_value_;
-
-                std::vector<std::vector<KDL::Frame> > segment_frames_;
-
-                std::vector<KDL::Wrench> wrenchSum_;
-                std::vector<std::vector<KDL::Vector> > linkPositions_;
-                std::vector<std::vector<KDL::Vector> > linkVelocities_;
-                std::vector<std::vector<KDL::Vector> > linkAngularVelocities_;
-                std::vector<KDL::Vector> CoMPositions_;
-                std::vector<KDL::Vector> CoMVelocities_;
-                std::vector<KDL::Vector> CoMAccelerations_;
-                std::vector<KDL::Vector> AngularMomentums_;
-                std::vector<KDL::Vector> Torques_;
-                std::vector<std::vector<Vector4d> > contactViolationVector_;
-                std::vector<std::vector<KDL::Vector> > contactPointVelVector_;
-
-                std::vector<double> state_collision_cost_;
-                std::vector<double> state_contact_invariant_cost_;
-                std::vector<double> state_physics_violation_cost_;
-                std::vector<double> state_ftr_cost_;
-        };
-
 public:
         enum DERIVATIVE_VARIABLE_TYPE
         {
@@ -96,15 +72,22 @@ public:
 
         void setTrajectory(const Eigen::MatrixXd& parameters, const Eigen::MatrixXd& vel_parameters,
                                            const Eigen::MatrixXd& contact_parameters);
-        void setTrajectory(const std::vector<Eigen::VectorXd>& parameters,
-                                           const std::vector<Eigen::VectorXd>& contact_parameters);
+        // parameters are num_free_points x num_joints, contact parameters num_contact_phases - 1 x num_contacts
+        void setTrajectory(const Eigen::Ref<const Eigen::MatrixXd>& parameters,
+                                           const Eigen::Ref<const Eigen::MatrixXd>& contact_parameters);
 
         double evaluate();
         double evaluate(Eigen::VectorXd& costs);
         double evaluateDerivatives(double value, DERIVATIVE_VARIABLE_TYPE variable_type, int free_point_index,
                                                            int joint_index);
+        double evaluateGradient(Eigen::MatrixXd& gradient);
+        void resetIncrementalEvaluation(); /**< the next evaluate() recomputes the whole trajectory */
 
-        bool isLastTrajectoryFeasible() const;
+        bool isLastTrajectoryFeasible() const; /**< approximate if the sdf or the collision cache is used */
+        bool checkLastTrajectoryFeasibility(); /**< confirms the approximate collision results with FCL */
+        void setSinglePrecision(bool single_precision);
+        long getLastEvaluationAllocationCount() const;
+        const CollisionCache* getCollisionCache() const;
 
         void handleJointLimits();
         void updateFullTrajectory();
@@ -120,6 +103,8 @@ public:
         void setData(EvaluationData* data);
         void setDataToDefault();
 
+        EvaluationManager* clone() const;
+
         void printDebugInfo();
 
 private:
@@ -128,7 +113,7 @@ private:
         bool performForwardKinematics();
         void computeTrajectoryValidity();
         void computeMassAndGravityForce();
-        void updateCoM(int point);
+        void computeCoM(int begin, int end);
         void computeCollisionCosts();
         void computeFTRs();
         void computeCartesianTrajectoryCosts();
@@ -137,17 +122,32 @@ private:
 
         void updateFullTrajectory(int point_index, int joint_index);
         bool performForwardKinematics(int begin, int end);
+        void setFKJointValues(int point, const KDL::JntArray& joint_array);
+        void invalidateFKJointValues(int point);
         void computeCollisionCosts(int begin, int end);
+        void computeSDFCollisionCosts(int begin, int end);
+        bool isTrajectoryCollisionFreeExact();
         void computeFTRs(int begin, int end);
         void computeSingularityCosts(int begin, int end);
 
+        void computeSmoothnessGradient(Eigen::MatrixXd& gradient);
+        void computeCollisionGradient(Eigen::MatrixXd& gradient);
+        void computeSDFCollisionGradient(double weight, Eigen::MatrixXd& gradient);
+        void computeCartesianTrajectoryGradient(Eigen::MatrixXd& gradient);
+        void addSegmentPositionGradient(int point, int segment, const KDL::Vector& position,
+                                        const KDL::Vector& direction, double scale, Eigen::MatrixXd& gradient) const;
+        void addSegmentRotationGradient(int point, int segment, const KDL::Vector& vector,
+                                        const KDL::Vector& direction, double scale, Eigen::MatrixXd& gradient) const;
+
+        bool computeDirtyRanges();
+        void updateEvaluatedTrajectory(int begin, int end);
+
         void backupAndSetVariables(double new_value, DERIVATIVE_VARIABLE_TYPE variable_type, int free_point_index,
                                                            int joint_index);
         void restoreVariable(DERIVATIVE_VARIABLE_TYPE variable_type, int free_point_index, int joint_index);
 
         int getIteration() const;
 
-        const KDL::Vector& getSegmentPosition(int point, const std::string& segmentName) const;
         const KDL::Vector& getSegmentPosition(int point, int segmentIndex) const;
 
         ItompCIOTrajectory* getGroupTrajectory();
@@ -162,6 +162,8 @@ private:
         const ItompRobotModel *robot_model_;
         const ItompPlanningGroup *planning_group_;
         std::string robot_name_;
+        int cartesian_tool_segment_; /**< segment following the cartesian path, -1 if not in the tree */
+        int cartesian_flange_segment_; /**< segment keeping the orientation constraint, -1 if not in the tree */
 
         int* iteration_;
 
@@ -175,22 +177,35 @@ private:
         int full_vars_end_;
 
         std::vector<int> group_joint_to_kdl_joint_index_;
+        std::vector<int> kdl_joint_to_group_joint_index_; /**< -1 for the joints not in the planning group */
+        std::vector<std::vector<int> > segment_group_joints_; /**< kdl indices of the group joints moving each segment */
 
         bool is_collision_free_;
         bool last_trajectory_collision_free_;
+        bool exact_collision_check_pending_; /**< the last evaluate() used approximate (SDF or cached) collision results */
+        boost::shared_ptr<CollisionCache> collision_cache_; /**< shared with the clones, NULL if disabled */
+        bool single_precision_; /**< forward kinematics in float, used for ranking the rollouts */
 
         bool trajectory_validity_;
 
+        std::vector<std::pair<int, int> > dirty_ranges_; /**< [begin, end) point ranges to be recomputed in incremental evaluation */
+
         // physics
+        struct MassSegment
+        {
+                int segment_index_; /**< index in the segment frames */
+                double mass_; /**< mass normalized by the total weight */
+                KDL::Vector cog_; /**< center of gravity in the segment frame */
+        };
         double total_mass_;
-        std::vector<double> masses_;
+        std::vector<MassSegment> mass_segments_; /**< segments with a mass, in the order of linkPositions_ */
         int num_mass_segments_;
         KDL::Vector gravity_force_;
 
         ros::Publisher vis_marker_array_pub_;
         ros::Publisher vis_marker_pub_;
 
-        BackupData backup_data_;
+        double backup_trajectory_value_; /**< value of the variable changed by backupAndSetVariables() */
 
         // TODO: refactoring
         int getSegmentIndex(int link, bool isLeft) const;
@@ -202,21 +217,21 @@ private:
         // for debug
         std::vector<double> timings_;
         int count_;
+        long last_evaluation_allocation_count_; /**< heap allocations made by the last evaluate() (needs COUNT_HEAP_ALLOCATIONS) */
 public:
         bool print_debug_texts_;
 
 };
 typedef boost::shared_ptr<EvaluationManager> EvaluationManagerPtr;
 
-inline bool EvaluationManager::isLastTrajectoryFeasible() const
+inline long EvaluationManager::getLastEvaluationAllocationCount() const
 {
-        return last_trajectory_collision_free_;
+        return last_evaluation_allocation_count_;
 }
 
-inline const KDL::Vector& EvaluationManager::getSegmentPosition(int point, const std::string& segmentName) const
+inline const CollisionCache* EvaluationManager::getCollisionCache() const
 {
-        int sn = robot_model_->getForwardKinematicsSolver()->segmentNameToIndex(segmentName);
-        return getSegmentPosition(point, sn);
+        return collision_cache_.get();
 }
 
 inline const KDL::Vector& EvaluationManager::getSegmentPosition(int point, int segmentIndex) const
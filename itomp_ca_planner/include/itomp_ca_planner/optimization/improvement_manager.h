@@ -53,6 +53,7 @@ public:
   virtual void initialize(EvaluationManager *evaluation_manager);
   virtual bool updatePlanningParameters();
   virtual void runSingleIteration(int iteration) = 0;
+  virtual void printStatistics() const {}
 
 protected:
   EvaluationManager *evaluation_manager_;
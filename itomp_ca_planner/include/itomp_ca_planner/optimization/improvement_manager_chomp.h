@@ -42,7 +42,9 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <itomp_ca_planner/common.h>
 #include <itomp_ca_planner/optimization/evaluation_manager.h>
 #include <itomp_ca_planner/optimization/rollout.h>
-#include <itomp_ca_planner/util/multivariate_gaussian.h>
+#include <itomp_ca_planner/util/banded_gaussian_sampler.h>
+#include <itomp_ca_planner/cost/smoothness_cost_cache.h>
+#include <itomp_ca_planner/util/differentiation_rules.h>
 
 namespace itomp_ca_planner
 {
@@ -55,12 +57,17 @@ public:
 
   virtual bool updatePlanningParameters();
   virtual void runSingleIteration(int iteration);
+  virtual void printStatistics() const;
 
 private:
   void initializeCosts();
   void initializeNoiseGenerators();
+  void projectUpdates(Eigen::Block<Eigen::MatrixXd> updates) const;
   void initializeRollouts();
+  void initializeRolloutEvaluationManagers();
   bool preAllocateTempVariables();
+  void evaluateRollouts();
+  void evaluateRollouts(bool single_precision);
   bool generateRollouts(const std::vector<double>& noise_stddev, const std::vector<double>& contact_noise_stddev);
   void copyGroupTrajectory();
   bool setRolloutCosts();
@@ -70,11 +77,11 @@ private:
   bool computeParameterUpdates();
   bool updateParameters();
   void getParameters();
-  void addExtraRollout(std::vector<Eigen::VectorXd>& parameters, std::vector<Eigen::VectorXd>& contact_parameters,
-      Eigen::VectorXd& costs);
-  bool computeNoise(Rollout& rollout);
-  bool computeProjectedNoise(Rollout& rollout);
-  void computeRolloutControlCost(Rollout& rollout);
+  void addExtraRollout(const Eigen::MatrixXd& parameters, const Eigen::MatrixXd& contact_parameters,
+      const Eigen::VectorXd& costs);
+  bool computeNoise(int slot);
+  bool computeProjectedNoise(int slot);
+  void computeRolloutControlCost(int slot);
 
   int last_planning_parameter_index_;
 
@@ -97,14 +104,16 @@ private:
 
   std::vector<Eigen::VectorXd> parameters_all_;
   std::vector<Eigen::VectorXd> contact_parameters_all_;
-  std::vector<Eigen::VectorXd> parameters_; /**< [num_dimensions] num_parameters */
-  std::vector<Eigen::VectorXd> contact_parameters_;
+  Eigen::MatrixXd parameters_; /**< num_parameters x num_dimensions */
+  Eigen::MatrixXd contact_parameters_; /**< num_contact_parameters x num_contact_dimensions */
 
   Eigen::MatrixXd rollout_costs_;
   Eigen::VectorXd tmp_rollout_cost_;
 
   bool use_cumulative_costs_;
   bool use_smooth_noises_;
+  bool use_parallel_rollout_evaluation_;
+  bool use_float_rollout_evaluation_;
 
   int num_rollouts_;
   int num_rollouts_reused_;
@@ -115,31 +124,39 @@ private:
   bool extra_rollouts_added_; /**< Have the "extra rollouts" been added for use in the next iteration? */
   std::vector<std::pair<double, int> > rollout_cost_sorter_; /**< vector used for sorting rollouts by their cost */
 
-  std::vector<Rollout> rollouts_;
-  std::vector<Rollout> reused_rollouts_;
-  std::vector<Rollout> extra_rollouts_;
+  Rollouts rollouts_; /**< [num_rollouts + num_rollouts_extra] slots */
+  std::vector<int> rollout_slots_; /**< [num_rollouts + num_rollouts_extra] slot of each rollout, the extra rollouts last */
 
-  std::vector<Eigen::MatrixXd> differentiation_matrices_;
-  std::vector<Eigen::MatrixXd> control_costs_all_;
-  std::vector<Eigen::MatrixXd> control_costs_; /**< [num_dimensions] num_parameters x num_parameters */
-  std::vector<Eigen::MatrixXd> inv_control_costs_; /**< [num_dimensions] num_parameters x num_parameters */
-  std::vector<Eigen::MatrixXd> projection_matrix_; /**< [num_dimensions] num_parameters x num_parameters */
+  std::vector<EvaluationManagerPtr> rollout_evaluation_managers_; /**< [num_rollouts + num_rollouts_extra] evaluation managers of the slots, with their own data for parallel rollout evaluation */
+  std::vector<Eigen::VectorXd> tmp_rollout_costs_; /**< [num_rollouts] num_time_steps */
+
+  // ranking of the float rollout evaluation compared with double
+  Eigen::MatrixXd float_rollout_costs_;
+  std::vector<std::pair<double, int> > float_rollout_cost_sorter_;
+  int num_ranking_checks_;
+  int num_ranking_changes_;
+  int num_best_rollout_changes_;
+
+  double differentiation_stencils_[NUM_DIFF_RULES][DIFF_RULE_LENGTH]; /**< DIFF_RULES scaled by the discretization */
+  SmoothnessCostCache::ControlCostConstPtr control_cost_; /**< factored control cost of the free variables, the same for every joint */
   double control_cost_weight_;
 
-  std::vector<MultivariateGaussian> noise_generators_; /**< objects that generate noise for each dimension */
-  std::vector<MultivariateGaussian> contact_noise_generators_; /**< objects that generate noise for each dimension */
+  std::vector<BandedGaussianSampler> noise_generators_; /**< objects that generate noise for each dimension */
+  std::vector<BandedGaussianSampler> contact_noise_generators_; /**< objects that generate noise for each dimension */
 
   // temporary variables pre-allocated for efficiency:
-  std::vector<Eigen::VectorXd> tmp_noise_; /**< [num_dimensions] num_parameters */
-  std::vector<Eigen::VectorXd> tmp_contact_noise_; /**< [num_dimensions] num_parameters */
-  std::vector<Eigen::VectorXd> tmp_parameters_; /**< [num_dimensions] num_parameters */
-  Eigen::VectorXd tmp_max_cost_; /**< num_time_steps */
-  Eigen::VectorXd tmp_min_cost_; /**< num_time_steps */
-  Eigen::VectorXd tmp_max_minus_min_cost_; /**< num_time_steps */
-  Eigen::VectorXd tmp_sum_rollout_probabilities_; /**< num_time_steps */
-  std::vector<Eigen::MatrixXd> parameter_updates_; /**< [num_dimensions] num_time_steps x num_parameters */
-  std::vector<Eigen::VectorXd> contact_parameter_updates_; /**< [num_dimensions] num_time_steps x num_parameters */
-  std::vector<Eigen::VectorXd> time_step_weights_; /**< [num_dimensions] num_time_steps: Weights computed for updates per time-step */
+  Eigen::MatrixXd tmp_noise_; /**< num_rollouts x num_parameters, noise of one dimension */
+  Eigen::MatrixXd tmp_contact_noise_; /**< num_rollouts x num_parameters, noise of one dimension */
+  Eigen::VectorXd tmp_parameters_all_; /**< num_vars_all */
+  std::vector<int> tmp_rollout_slots_; /**< [num_rollouts + num_rollouts_extra] */
+  std::vector<char> tmp_rollout_reused_; /**< [num_rollouts + num_rollouts_extra] */
+  Eigen::MatrixXd tmp_max_cost_; /**< num_time_steps x num_dimensions */
+  Eigen::MatrixXd tmp_min_cost_; /**< num_time_steps x num_dimensions */
+  Eigen::MatrixXd tmp_inv_cost_range_; /**< num_time_steps x num_dimensions */
+  Eigen::MatrixXd tmp_sum_rollout_probabilities_; /**< num_time_steps x num_dimensions */
+  Eigen::MatrixXd parameter_updates_; /**< num_parameters x num_dimensions */
+  Eigen::MatrixXd contact_parameter_updates_; /**< num_contact_parameters x num_contact_dimensions */
+  Eigen::MatrixXd time_step_weights_; /**< num_time_steps x num_dimensions: Weights computed for updates per time-step */
 
 };
 
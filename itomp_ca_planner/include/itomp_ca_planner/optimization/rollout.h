@@ -43,25 +43,63 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 namespace itomp_ca_planner
 {
 
-class Rollout
+/**
+ * \brief Trajectories and costs of all rollouts, stored as contiguous tensors
+ *
+ * Each tensor is one column-major matrix laid out as [slot][dimension][time step], so the
+ * num_time_steps x num_dimensions block of a slot is contiguous and whole-tensor operations
+ * run over a single allocation. Rollouts refer to their data by slot, so reordering the
+ * rollouts only permutes slot indices.
+ */
+class Rollouts
 {
 public:
-	std::vector<Eigen::VectorXd> parameters_; /**< [num_dimensions] num_parameters */
-	std::vector<Eigen::VectorXd> noise_; /**< [num_dimensions] num_parameters */
-	std::vector<Eigen::VectorXd> noise_projected_; /**< [num_dimensions][num_time_steps] num_parameters */
-	std::vector<Eigen::VectorXd> parameters_noise_projected_; /**< [num_dimensions][num_time_steps] num_parameters */
-	Eigen::VectorXd state_costs_; /**< num_time_steps */
-	std::vector<Eigen::VectorXd> control_costs_; /**< [num_dimensions] num_time_steps */
-	std::vector<Eigen::VectorXd> total_costs_; /**< [num_dimensions] num_time_steps */
-	std::vector<Eigen::VectorXd> cumulative_costs_; /**< [num_dimensions] num_time_steps */
-	std::vector<Eigen::VectorXd> probabilities_; /**< [num_dimensions] num_time_steps */
-
-	std::vector<Eigen::VectorXd> contact_parameters_; /**< [num_dimensions] num_parameters */
-	std::vector<Eigen::VectorXd> contact_noise_; /**< [num_dimensions] num_parameters */
-	Eigen::VectorXd contact_probabilities_; /**< [num_dimensions] num_time_steps */
-
-	double getCost(); /**< Gets the rollout cost = state cost + control costs per dimension */
+	Rollouts();
+
+	void resize(int num_slots, int num_dimensions, int num_time_steps, int num_contact_dimensions,
+			int num_contact_time_steps);
+
+	int getNumSlots() const;
+
+	// num_time_steps x num_dimensions block of the slot in one of the tensors
+	Eigen::Block<Eigen::MatrixXd> getSlot(Eigen::MatrixXd& tensor, int slot) const;
+	const Eigen::Block<const Eigen::MatrixXd> getSlot(const Eigen::MatrixXd& tensor, int slot) const;
+
+	double getCost(int slot) const; /**< Gets the rollout cost = state cost + control costs per dimension */
+
+	Eigen::MatrixXd parameters_; /**< num_parameters x [num_slots][num_dimensions] */
+	Eigen::MatrixXd noise_; /**< num_parameters x [num_slots][num_dimensions] */
+	Eigen::MatrixXd noise_projected_; /**< num_parameters x [num_slots][num_dimensions] */
+	Eigen::MatrixXd state_costs_; /**< num_time_steps x num_slots */
+	Eigen::MatrixXd control_costs_; /**< num_time_steps x [num_slots][num_dimensions] */
+	Eigen::MatrixXd cumulative_costs_; /**< num_time_steps x [num_slots][num_dimensions] */
+	Eigen::MatrixXd probabilities_; /**< num_time_steps x [num_slots][num_dimensions] */
+
+	Eigen::MatrixXd contact_parameters_; /**< num_parameters x [num_slots][num_contact_dimensions] */
+	Eigen::MatrixXd contact_noise_; /**< num_parameters x [num_slots][num_contact_dimensions] */
+	Eigen::MatrixXd contact_probabilities_; /**< num_time_steps x num_slots */
+
+private:
+	int num_slots_;
 };
+
+inline int Rollouts::getNumSlots() const
+{
+	return num_slots_;
+}
+
+inline Eigen::Block<Eigen::MatrixXd> Rollouts::getSlot(Eigen::MatrixXd& tensor, int slot) const
+{
+	int cols = tensor.cols() / num_slots_;
+	return tensor.block(0, slot * cols, tensor.rows(), cols);
+}
+
+inline const Eigen::Block<const Eigen::MatrixXd> Rollouts::getSlot(const Eigen::MatrixXd& tensor, int slot) const
+{
+	int cols = tensor.cols() / num_slots_;
+	return tensor.block(0, slot * cols, tensor.rows(), cols);
+}
+
 }
 
 #endif
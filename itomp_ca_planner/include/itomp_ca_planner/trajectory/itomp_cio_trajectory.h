@@ -139,6 +139,7 @@ public:
 	void printTrajectory() const;
 
 	int getNumFreePoints() const;
+	int getStartIndex() const;
 
 	Eigen::Block<Eigen::MatrixXd, Eigen::Dynamic, Eigen::Dynamic> getFreeTrajectoryBlock();
 	Eigen::Block<Eigen::MatrixXd, Eigen::Dynamic, Eigen::Dynamic> getFreeJointTrajectoryBlock(
@@ -352,6 +353,11 @@ inline int ItompCIOTrajectory::getNumFreePoints() const
 	return (end_index_ - start_index_) + 1;
 }
 
+inline int ItompCIOTrajectory::getStartIndex() const
+{
+	return start_index_;
+}
+
 inline Eigen::Block<Eigen::MatrixXd, Eigen::Dynamic, Eigen::Dynamic> ItompCIOTrajectory::getFreeTrajectoryBlock()
 {
 	return trajectory_.block(start_index_, 0, getNumFreePoints(),
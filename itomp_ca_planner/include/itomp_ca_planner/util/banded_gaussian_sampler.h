@@ -0,0 +1,82 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#ifndef BANDED_GAUSSIAN_SAMPLER_H_
+#define BANDED_GAUSSIAN_SAMPLER_H_
+
+#include <itomp_ca_planner/common.h>
+#include <itomp_ca_planner/util/banded_cholesky.h>
+#include <boost/random/variate_generator.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/mersenne_twister.hpp>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Generates zero-mean samples of a gaussian distribution given its banded precision matrix
+ *
+ * With the precision factored as A = L L^T, x = L^-T z has the covariance A^-1, so a sample
+ * is a banded triangular solve instead of a product with the dense cholesky of the covariance.
+ */
+class BandedGaussianSampler
+{
+public:
+	BandedGaussianSampler(const BandedCholesky& precision_cholesky);
+
+	int getSize() const;
+
+	// fills the first num_samples rows of output with samples, output is resized only if it is too small
+	void sample(Eigen::MatrixXd& output, int num_samples);
+
+private:
+	BandedCholesky precision_cholesky_;
+
+	boost::mt19937 rng_;
+	boost::normal_distribution<> normal_dist_;
+	boost::shared_ptr<boost::variate_generator<boost::mt19937, boost::normal_distribution<> > > gaussian_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline int BandedGaussianSampler::getSize() const
+{
+	return precision_cholesky_.getSize();
+}
+
+}
+#endif
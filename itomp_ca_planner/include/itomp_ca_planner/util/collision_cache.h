@@ -0,0 +1,179 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#ifndef COLLISION_CACHE_H_
+#define COLLISION_CACHE_H_
+
+#include <itomp_ca_planner/common.h>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Lock-free cache of collision results keyed by a quantized joint configuration.
+ *
+ * Each slot stores (key ^ data, data) as two words, so a slot torn by a concurrent store is detected
+ * on lookup and treated as a miss. The key and a 31 bit check are two independent hashes of the
+ * quantized configuration; a false hit needs both of them to collide.
+ */
+class CollisionCache
+{
+public:
+	CollisionCache(int capacity, double quantum) :
+			inv_quantum_(1.0 / quantum), num_hits_(0), num_misses_(0)
+	{
+		int size = 1;
+		while (size < capacity)
+			size <<= 1;
+		mask_ = size - 1;
+		slots_.resize(size);
+		clear();
+	}
+
+	void clear()
+	{
+		for (std::size_t i = 0; i < slots_.size(); ++i)
+		{
+			slots_[i].key_ = 0;
+			slots_[i].data_ = 0;
+		}
+		num_hits_ = num_misses_ = 0;
+	}
+
+	// hashes the quantized configuration, the result is used for both lookup and insert
+	void computeKey(const double* positions, int num_positions, boost::uint64_t& key, boost::uint32_t& check) const
+	{
+		boost::uint64_t h1 = 0xcbf29ce484222325ULL;
+		boost::uint64_t h2 = 0x9e3779b97f4a7c15ULL;
+		for (int i = 0; i < num_positions; ++i)
+		{
+			boost::uint64_t q = (boost::uint64_t)(boost::int64_t)std::floor(positions[i] * inv_quantum_ + 0.5);
+			h1 = (h1 ^ q) * 0x100000001b3ULL;
+			h2 = mix(h2 + q);
+		}
+		key = mix(h1);
+		// the check is never 0, so that an empty slot never matches
+		check = (boost::uint32_t)(h2 >> 33) | 1;
+	}
+
+	bool lookup(boost::uint64_t key, boost::uint32_t check, double& depth_sum, bool& in_collision)
+	{
+		for (int i = 0; i < NUM_PROBES; ++i)
+		{
+			const Slot& slot = slots_[(key + i) & mask_];
+			boost::uint64_t data = slot.data_;
+			boost::uint64_t stored_key = slot.key_ ^ data;
+			if (stored_key == key && (boost::uint32_t)(data >> 33) == check)
+			{
+				float depth;
+				boost::uint32_t bits = (boost::uint32_t)data;
+				memcpy(&depth, &bits, sizeof(depth));
+				depth_sum = depth;
+				in_collision = (data >> 32) & 1;
+				__sync_fetch_and_add(&num_hits_, 1);
+				return true;
+			}
+		}
+		__sync_fetch_and_add(&num_misses_, 1);
+		return false;
+	}
+
+	void insert(boost::uint64_t key, boost::uint32_t check, double depth_sum, bool in_collision)
+	{
+		float depth = (float)depth_sum;
+		boost::uint32_t bits;
+		memcpy(&bits, &depth, sizeof(bits));
+		boost::uint64_t data = ((boost::uint64_t)check << 33) | ((boost::uint64_t)in_collision << 32) | bits;
+
+		// first empty slot of the probe sequence, otherwise the home slot is replaced
+		Slot* target = &slots_[key & mask_];
+		for (int i = 0; i < NUM_PROBES; ++i)
+		{
+			Slot& slot = slots_[(key + i) & mask_];
+			if (slot.data_ == 0)
+			{
+				target = &slot;
+				break;
+			}
+		}
+		target->data_ = data;
+		target->key_ = key ^ data;
+	}
+
+	long getNumHits() const
+	{
+		return num_hits_;
+	}
+
+	long getNumMisses() const
+	{
+		return num_misses_;
+	}
+
+private:
+	static const int NUM_PROBES = 4;
+
+	struct Slot
+	{
+		volatile boost::uint64_t key_; /**< key ^ data */
+		volatile boost::uint64_t data_; /**< check (31 bits) | in collision (1 bit) | depth sum (float) */
+	};
+
+	static boost::uint64_t mix(boost::uint64_t x)
+	{
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdULL;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ULL;
+		x ^= x >> 33;
+		return x;
+	}
+
+	double inv_quantum_;
+	boost::uint64_t mask_;
+	std::vector<Slot> slots_;
+	volatile long num_hits_;
+	volatile long num_misses_;
+};
+
+}
+
+#endif /* COLLISION_CACHE_H_ */
@@ -0,0 +1,129 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#ifndef CONTIGUOUS_ARRAY_2D_H_
+#define CONTIGUOUS_ARRAY_2D_H_
+
+#include <itomp_ca_planner/common.h>
+#include <ros/assert.h>
+#include <vector>
+#include <algorithm>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Row-major 2D array stored in a single aligned buffer.
+ *
+ * Replaces std::vector<std::vector<T> > for the per-point buffers of the evaluation data
+ * ([point][segment] frames, [segment][point] link positions, ...).
+ * operator[] returns a pointer to the row, so element access keeps the a[i][j] syntax.
+ */
+template<typename T>
+class ContiguousArray2D
+{
+public:
+	ContiguousArray2D() :
+			rows_(0), cols_(0)
+	{
+	}
+	ContiguousArray2D(int rows, int cols, const T& value = T()) :
+			rows_(0), cols_(0)
+	{
+		resize(rows, cols, value);
+	}
+
+	void resize(int rows, int cols, const T& value = T())
+	{
+		rows_ = rows;
+		cols_ = cols;
+		data_.assign(rows * cols, value);
+	}
+
+	void setConstant(const T& value)
+	{
+		std::fill(data_.begin(), data_.end(), value);
+	}
+
+	int rows() const
+	{
+		return rows_;
+	}
+	int cols() const
+	{
+		return cols_;
+	}
+	int size() const
+	{
+		return data_.size();
+	}
+
+	T* operator[](int row)
+	{
+		return &data_[row * cols_];
+	}
+	const T* operator[](int row) const
+	{
+		return &data_[row * cols_];
+	}
+
+	T* data()
+	{
+		return &data_[0];
+	}
+	const T* data() const
+	{
+		return &data_[0];
+	}
+
+	// copies num_rows rows starting at src_row of src to the rows starting at dst_row
+	void copyRows(const ContiguousArray2D& src, int src_row, int dst_row, int num_rows)
+	{
+		ROS_ASSERT(cols_ == src.cols_);
+		std::copy(src.data_.begin() + src_row * cols_, src.data_.begin() + (src_row + num_rows) * cols_,
+				data_.begin() + dst_row * cols_);
+	}
+
+private:
+	int rows_;
+	int cols_;
+	std::vector<T, Eigen::aligned_allocator<T> > data_;
+};
+
+}
+
+#endif /* CONTIGUOUS_ARRAY_2D_H_ */
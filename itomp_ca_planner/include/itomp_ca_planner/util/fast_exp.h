@@ -0,0 +1,97 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#ifndef FAST_EXP_H_
+#define FAST_EXP_H_
+
+#include <itomp_ca_planner/common.h>
+#include <boost/cstdint.hpp>
+#include <cstring>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief x = exp(x) for a contiguous array
+ *
+ * exp(x) = 2^k exp(r) with k = round(x / ln 2) and |r| <= ln 2 / 2, exp(r) from a degree 11
+ * polynomial (relative error below 1e-14). The loop is branch-free and uses only
+ * arithmetic and 64-bit integer operations, so it is vectorized by the compiler
+ * (a clamp would not be, under the default -ftrapping-math). Inputs must be in [-708, 708].
+ */
+inline void expInPlace(double* x, int size)
+{
+	const double LOG2E = 1.4426950408889634;
+	const double LN2_HI = 0.693145751953125;
+	const double LN2_LO = 1.42860682030941723212e-6;
+	const double SHIFTER = 6755399441055744.0; // 1.5 * 2^52, rounds to an integer in the low mantissa bits
+
+	for (int i = 0; i < size; ++i)
+	{
+		double v = x[i];
+
+		double shifted = v * LOG2E + SHIFTER;
+		double k = shifted - SHIFTER;
+		double r = (v - k * LN2_HI) - k * LN2_LO;
+
+		double p = 1.0 / 39916800.0;
+		p = p * r + 1.0 / 3628800.0;
+		p = p * r + 1.0 / 362880.0;
+		p = p * r + 1.0 / 40320.0;
+		p = p * r + 1.0 / 5040.0;
+		p = p * r + 1.0 / 720.0;
+		p = p * r + 1.0 / 120.0;
+		p = p * r + 1.0 / 24.0;
+		p = p * r + 1.0 / 6.0;
+		p = p * r + 0.5;
+		p = p * r + 1.0;
+		p = p * r + 1.0;
+
+		// 2^k from the exponent bits, k being in the low bits of shifted
+		boost::int64_t bits;
+		std::memcpy(&bits, &shifted, sizeof(bits));
+		bits = (bits + 1023) << 52;
+		double scale;
+		std::memcpy(&scale, &bits, sizeof(scale));
+
+		x[i] = p * scale;
+	}
+}
+
+}
+
+#endif /* FAST_EXP_H_ */
@@ -54,10 +54,11 @@ inline void debugJointArray(KDL::JntArray& joint_array)
 #define MEASURE_TIME
 
 #ifdef MEASURE_TIME
-#define INIT_TIME_MEASUREMENT(N) std::vector<ros::Time> times;static int count=0;static double elapsed[N];if (count==0) for(int i=0;i<N;++i) elapsed[i]=0.0;
-#define ADD_TIMER_POINT times.push_back(ros::Time::now());
-#define UPDATE_TIME for(int i=0; i < times.size()-1; ++i) elapsed[i]+=(times[i+1] - times[i]).toSec();
-#define PRINT_TIME(name, c) if (++count % c == 0) for(int i=0; i < times.size()-1; ++i) printf("%s Timing %d : %f %f\n", #name, i, elapsed[i], elapsed[i] / count);
+// the totals are per thread, the evaluations of parallel rollouts would race on shared ones
+#define INIT_TIME_MEASUREMENT(N) ros::Time times[N];int num_times=0;static __thread int count=0;static __thread double elapsed[N];if (count==0) for(int i=0;i<N;++i) elapsed[i]=0.0;
+#define ADD_TIMER_POINT times[num_times++] = ros::Time::now();
+#define UPDATE_TIME for(int i=0; i < num_times-1; ++i) elapsed[i]+=(times[i+1] - times[i]).toSec();
+#define PRINT_TIME(name, c) if (++count % c == 0) for(int i=0; i < num_times-1; ++i) printf("%s Timing %d : %f %f\n", #name, i, elapsed[i], elapsed[i] / count);
 #else
 #define INIT_TIME_MEASUREMENT(N)
 #define ADD_TIMER_POINT
@@ -63,6 +63,13 @@ public:
 	int getMaxIterationsAfterCollisionFree() const;
 	double getSmoothnessCostWeight() const;
 	double getObstacleCostWeight() const;
+	bool getUseSDFCollisionCost() const;
+	double getSDFResolution() const;
+	double getSDFClearance() const;
+	bool getUseCollisionCache() const;
+	double getCollisionCacheQuantum() const;
+	int getCollisionCacheCapacity() const;
+	bool getUseBatchForwardKinematics() const;
 	double getStateValidityCostWeight() const;
 	double getEndeffectorVelocityCostWeight() const;
 	double getTorqueCostWeight() const;
@@ -73,6 +80,9 @@ public:
 	double getFTRCostWeight() const;
 	double getCartesianTrajectoryCostWeight() const;
 	double getSingularityCostWeight() const;
+	double getSingularityManipulabilityThreshold() const;
+	const std::string& getCartesianTrajectoryToolLink() const;
+	const std::string& getCartesianTrajectoryFlangeLink() const;
 
 	bool getAnimatePath() const;
 	double getSmoothnessCostVelocity() const;
@@ -90,6 +100,11 @@ public:
 	double getNoiseDecay() const;
 	bool getUseCumulativeCosts() const;
 	bool getUseSmoothNoises() const;
+	bool getUseParallelRolloutEvaluation() const;
+	bool getUseIncrementalEvaluation() const;
+	double getIncrementalEvaluationTolerance() const;
+	bool getUseFloatRolloutEvaluation() const;
+	bool getFloatRolloutRankingCheck() const;
 	int getNumContacts() const;
 	const std::vector<double>& getContactVariableInitialValues() const;
 	const std::vector<double>& getContactVariableGoalValues() const;
@@ -149,6 +164,13 @@ private:
 	int max_iterations_after_collision_free_;
 	double smoothness_cost_weight_;
 	double obstacle_cost_weight_;
+	bool use_sdf_collision_cost_;
+	double sdf_resolution_;
+	double sdf_clearance_;
+	bool use_collision_cache_;
+	double collision_cache_quantum_;
+	int collision_cache_capacity_;
+	bool use_batch_forward_kinematics_;
 	double state_validity_cost_weight_;
 	double torque_cost_weight_;
 	double endeffector_velocity_cost_weight_;
@@ -159,6 +181,9 @@ private:
 	double ftr_cost_weight_;
 	double cartesian_trajectory_cost_weight_;
 	double singularity_cost_weight_;
+	double singularity_manipulability_threshold_;
+	std::string cartesian_trajectory_tool_link_;
+	std::string cartesian_trajectory_flange_link_;
 	bool animate_path_;
 	double smoothness_cost_velocity_;
 	double smoothness_cost_acceleration_;
@@ -190,6 +215,11 @@ private:
 	double noise_decay_;
 	bool use_cumulative_costs_;
 	bool use_smooth_noises_;
+	bool use_parallel_rollout_evaluation_;
+	bool use_incremental_evaluation_;
+	double incremental_evaluation_tolerance_;
+	bool use_float_rollout_evaluation_;
+	bool float_rollout_ranking_check_;
 
 	std::vector<double> temporary_variables_;
 
@@ -263,6 +293,41 @@ inline double PlanningParameters::getObstacleCostWeight() const
 	return obstacle_cost_weight_;
 }
 
+inline bool PlanningParameters::getUseSDFCollisionCost() const
+{
+	return use_sdf_collision_cost_;
+}
+
+inline double PlanningParameters::getSDFResolution() const
+{
+	return sdf_resolution_;
+}
+
+inline double PlanningParameters::getSDFClearance() const
+{
+	return sdf_clearance_;
+}
+
+inline bool PlanningParameters::getUseCollisionCache() const
+{
+	return use_collision_cache_;
+}
+
+inline double PlanningParameters::getCollisionCacheQuantum() const
+{
+	return collision_cache_quantum_;
+}
+
+inline int PlanningParameters::getCollisionCacheCapacity() const
+{
+	return collision_cache_capacity_;
+}
+
+inline bool PlanningParameters::getUseBatchForwardKinematics() const
+{
+	return use_batch_forward_kinematics_;
+}
+
 inline double PlanningParameters::getStateValidityCostWeight() const
 {
 	return state_validity_cost_weight_;
@@ -303,6 +368,21 @@ inline double PlanningParameters::getSingularityCostWeight() const
 	return singularity_cost_weight_;
 }
 
+inline double PlanningParameters::getSingularityManipulabilityThreshold() const
+{
+	return singularity_manipulability_threshold_;
+}
+
+inline const std::string& PlanningParameters::getCartesianTrajectoryToolLink() const
+{
+	return cartesian_trajectory_tool_link_;
+}
+
+inline const std::string& PlanningParameters::getCartesianTrajectoryFlangeLink() const
+{
+	return cartesian_trajectory_flange_link_;
+}
+
 inline bool PlanningParameters::getAnimatePath() const
 {
 	return animate_path_;
@@ -411,6 +491,26 @@ inline bool PlanningParameters::getUseSmoothNoises() const
 {
 	return use_smooth_noises_;
 }
+inline bool PlanningParameters::getUseParallelRolloutEvaluation() const
+{
+	return use_parallel_rollout_evaluation_;
+}
+inline bool PlanningParameters::getUseIncrementalEvaluation() const
+{
+	return use_incremental_evaluation_;
+}
+inline double PlanningParameters::getIncrementalEvaluationTolerance() const
+{
+	return incremental_evaluation_tolerance_;
+}
+inline bool PlanningParameters::getUseFloatRolloutEvaluation() const
+{
+	return use_float_rollout_evaluation_;
+}
+inline bool PlanningParameters::getFloatRolloutRankingCheck() const
+{
+	return float_rollout_ranking_check_;
+}
 
 inline std::string PlanningParameters::getEnvironmentModel() const
 {
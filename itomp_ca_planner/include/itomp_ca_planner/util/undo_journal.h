@@ -0,0 +1,134 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#ifndef UNDO_JOURNAL_H_
+#define UNDO_JOURNAL_H_
+
+#include <itomp_ca_planner/common.h>
+#include <vector>
+#include <cstring>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Records the old contents of memory ranges before they are overwritten, so they can be restored later.
+ *
+ * Only plain data (no pointers to owned memory) can be recorded. Nothing is recorded unless a checkpoint is active.
+ */
+class UndoJournal
+{
+public:
+	UndoJournal() :
+			used_(0), recording_(false)
+	{
+	}
+
+	// preallocates the buffers so that recording does not allocate
+	void reserve(std::size_t num_bytes, int num_entries)
+	{
+		buffer_.resize(num_bytes);
+		entries_.reserve(num_entries);
+	}
+
+	// starts recording, discarding any previous records
+	void checkpoint()
+	{
+		entries_.clear();
+		used_ = 0;
+		recording_ = true;
+	}
+
+	bool isRecording() const
+	{
+		return recording_;
+	}
+
+	// saves count elements starting at data if a checkpoint is active
+	template<typename T>
+	void record(T* data, int count)
+	{
+		if (!recording_ || count <= 0)
+			return;
+
+		Entry entry;
+		entry.target_ = reinterpret_cast<char*>(data);
+		entry.offset_ = used_;
+		entry.size_ = sizeof(T) * count;
+		if (used_ + entry.size_ > buffer_.size())
+			buffer_.resize(used_ + entry.size_);
+		memcpy(&buffer_[used_], entry.target_, entry.size_);
+		used_ += entry.size_;
+		entries_.push_back(entry);
+	}
+
+	// restores the recorded ranges in reverse order and stops recording
+	void rollback()
+	{
+		for (int i = (int) entries_.size() - 1; i >= 0; --i)
+		{
+			const Entry& entry = entries_[i];
+			memcpy(entry.target_, &buffer_[entry.offset_], entry.size_);
+		}
+		discard();
+	}
+
+	// stops recording, keeping the current contents
+	void discard()
+	{
+		entries_.clear();
+		used_ = 0;
+		recording_ = false;
+	}
+
+private:
+	struct Entry
+	{
+		char* target_;
+		std::size_t offset_;
+		std::size_t size_;
+	};
+
+	std::vector<char> buffer_;
+	std::size_t used_;
+	std::vector<Entry> entries_;
+	bool recording_;
+};
+
+}
+
+#endif /* UNDO_JOURNAL_H_ */
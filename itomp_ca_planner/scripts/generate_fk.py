@@ -0,0 +1,247 @@
+#!/usr/bin/env python
+# Generates unrolled forward kinematics for a fixed robot from its URDF.
+#
+# usage: generate_fk.py robot.urdf output.cpp
+#
+# The segments and joints are numbered the way kdl_parser builds the KDL tree (depth first,
+# children in joint name order), so the outputs can replace
+# KDL::TreeFkSolverJointPosAxisPartial::JntToCartFull. ItompRobotModel checks the generated
+# function against KDL before using it.
+
+import math
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+
+def parse_vector(text, default):
+    if text is None:
+        return default
+    return [float(v) for v in text.split()]
+
+
+def rpy_to_matrix(rpy):
+    # same convention as KDL::Rotation::RPY
+    sr, cr = math.sin(rpy[0]), math.cos(rpy[0])
+    sp, cp = math.sin(rpy[1]), math.cos(rpy[1])
+    sy, cy = math.sin(rpy[2]), math.cos(rpy[2])
+    return [[cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr],
+            [sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr],
+            [-sp, cp * sr, cp * cr]]
+
+
+class Joint(object):
+    def __init__(self, element):
+        self.name = element.get('name')
+        self.type = element.get('type')
+        self.parent = element.find('parent').get('link')
+        self.child = element.find('child').get('link')
+        origin = element.find('origin')
+        xyz = parse_vector(origin.get('xyz') if origin is not None else None, [0.0, 0.0, 0.0])
+        rpy = parse_vector(origin.get('rpy') if origin is not None else None, [0.0, 0.0, 0.0])
+        self.rotation = rpy_to_matrix(rpy)
+        self.translation = xyz
+        axis = element.find('axis')
+        self.axis = parse_vector(axis.get('xyz') if axis is not None else None, [1.0, 0.0, 0.0])
+        norm = math.sqrt(sum(a * a for a in self.axis))
+        self.axis = [a / norm for a in self.axis]
+        if element.find('mimic') is not None:
+            raise ValueError('mimic joint %s is not supported' % self.name)
+
+    def is_rotational(self):
+        return self.type in ('revolute', 'continuous')
+
+    def is_translational(self):
+        return self.type == 'prismatic'
+
+
+# Expressions are either float constants or strings naming generated variables,
+# so the fixed transforms are folded while the code is emitted.
+
+def mul(a, b):
+    if isinstance(a, float) and isinstance(b, float):
+        return a * b
+    if isinstance(a, float):
+        a, b = b, a
+    if isinstance(b, float):
+        if b == 0.0:
+            return 0.0
+        if b == 1.0:
+            return a
+        if b == -1.0:
+            return a[1:] if a.startswith('-') else '-' + a
+        return '%s * %r' % (a, b)
+    return '%s * %s' % (a, b)
+
+
+def code(expression):
+    return repr(expression) if isinstance(expression, float) else expression
+
+
+def add(terms):
+    constant = 0.0
+    symbols = []
+    for t in terms:
+        if isinstance(t, float):
+            constant += t
+        else:
+            symbols.append(t)
+    if not symbols:
+        return constant
+    if constant != 0.0:
+        symbols.append(repr(constant))
+    code = symbols[0]
+    for s in symbols[1:]:
+        code += (' - ' + s[1:]) if s.startswith('-') else (' + ' + s)
+    return code
+
+
+class Generator(object):
+    def __init__(self):
+        self.lines = []
+
+    def define(self, name, expression):
+        if isinstance(expression, float) or re.match(r'^[A-Za-z_]\w*$', expression):
+            return expression
+        self.lines.append('\tconst double %s = %s;' % (name, expression))
+        return name
+
+    def multiply(self, name, parent, child):
+        # frames are (3x3 rotation, translation) of expressions
+        R = [[self.define('%s_r%d%d' % (name, r, c),
+                          add([mul(parent[0][r][k], child[0][k][c]) for k in range(3)]))
+              for c in range(3)] for r in range(3)]
+        p = [self.define('%s_p%d' % (name, r),
+                         add([mul(parent[0][r][k], child[1][k]) for k in range(3)] + [parent[1][r]]))
+             for r in range(3)]
+        return (R, p)
+
+
+def axis_rotation(gen, q_nr, axis):
+    c = 'c%d' % q_nr
+    s = 's%d' % q_nr
+    unit = [i for i in range(3) if abs(axis[i]) == 1.0]
+    if unit:
+        i = unit[0]
+        sign = axis[i]
+        j, k = (i + 1) % 3, (i + 2) % 3
+        R = [[0.0] * 3 for _ in range(3)]
+        R[i][i] = 1.0
+        R[j][j] = c
+        R[k][k] = c
+        R[k][j] = s if sign > 0 else '-' + s
+        R[j][k] = '-' + s if sign > 0 else s
+        return R
+    # Rodrigues for a general axis
+    v = gen.define('v%d' % q_nr, '1.0 - %s' % c)
+    x, y, z = axis
+    K = [[0.0, -z, y], [z, 0.0, -x], [-y, x, 0.0]]
+    R = [[None] * 3 for _ in range(3)]
+    for r in range(3):
+        for cc in range(3):
+            terms = [mul(v, axis[r] * axis[cc]), mul(s, K[r][cc])]
+            if r == cc:
+                terms.append(c)
+            R[r][cc] = gen.define('a%d_%d%d' % (q_nr, r, cc), add(terms))
+    return R
+
+
+def generate(urdf_file):
+    robot = ET.parse(urdf_file).getroot()
+    robot_name = robot.get('name')
+    links = [l.get('name') for l in robot.findall('link')]
+    joints = [Joint(j) for j in robot.findall('joint')]
+    children = dict((l, []) for l in links)
+    child_links = set()
+    for joint in sorted(joints, key=lambda j: j.name):
+        children[joint.parent].append(joint)
+        child_links.add(joint.child)
+    roots = [l for l in links if l not in child_links]
+    if len(roots) != 1:
+        raise ValueError('the URDF must have exactly one root link')
+
+    gen = Generator()
+    segment_names = [roots[0]]
+    identity = ([[1.0, 0.0, 0.0], [0.0, 1.0, 0.0], [0.0, 0.0, 1.0]], [0.0, 0.0, 0.0])
+    frames = [identity]
+    num_joints = [0]
+
+    def visit(link, frame):
+        for joint in children[link]:
+            segment_nr = len(segment_names)
+            segment_names.append(joint.child)
+            name = 'f%d' % segment_nr
+            gen.lines.append('\t// %s' % joint.child)
+            origin = (joint.rotation, joint.translation)
+            if joint.is_rotational() or joint.is_translational():
+                q_nr = num_joints[0]
+                num_joints[0] += 1
+                base = gen.multiply('g%d' % segment_nr, frame, origin)
+                axis = [gen.define('j%d_a%d' % (q_nr, r), add([mul(base[0][r][k], joint.axis[k]) for k in range(3)]))
+                        for r in range(3)]
+                gen.lines.append('\tjoint_pos[%d] = KDL::Vector(%s);' % (q_nr, ', '.join(code(v) for v in base[1])))
+                gen.lines.append('\tjoint_axis[%d] = KDL::Vector(%s);' % (q_nr, ', '.join(code(v) for v in axis)))
+                if joint.is_rotational():
+                    gen.lines.append('\tconst double s%d = std::sin(q[%d]), c%d = std::cos(q[%d]);' %
+                                     (q_nr, q_nr, q_nr, q_nr))
+                    child = gen.multiply(name, base, (axis_rotation(gen, q_nr, joint.axis), [0.0, 0.0, 0.0]))
+                else:
+                    p = [gen.define('%s_p%d' % (name, r), add([mul(axis[r], 'q[%d]' % q_nr), base[1][r]]))
+                         for r in range(3)]
+                    child = (base[0], p)
+            else:
+                child = gen.multiply(name, frame, origin)
+            frames.append(child)
+            visit(joint.child, child)
+
+    visit(roots[0], identity)
+
+    for i, (R, p) in enumerate(frames):
+        values = [code(R[r][c]) for r in range(3) for c in range(3)] + [code(v) for v in p]
+        gen.lines.append('\tsegment_frames[%d] = KDL::Frame(KDL::Rotation(%s), KDL::Vector(%s));' %
+                         (i, ', '.join(values[:9]), ', '.join(values[9:])))
+
+    return robot_name, segment_names, num_joints[0], gen.lines
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write('usage: %s robot.urdf output.cpp\n' % sys.argv[0])
+        return 1
+    robot_name, segment_names, num_joints, lines = generate(sys.argv[1])
+    identifier = re.sub('[^0-9a-zA-Z_]', '_', robot_name)
+
+    out = []
+    out.append('// Generated by generate_fk.py from %s, do not edit.' % sys.argv[1])
+    out.append('#include <itomp_ca_planner/model/generated_fk.h>')
+    out.append('#include <cmath>')
+    out.append('')
+    out.append('namespace')
+    out.append('{')
+    out.append('')
+    out.append('const char* segment_names[] =')
+    out.append('{')
+    for name in segment_names:
+        out.append('\t"%s",' % name)
+    out.append('};')
+    out.append('')
+    out.append('void fk_%s(const double* q, KDL::Vector* joint_pos, KDL::Vector* joint_axis, '
+               'KDL::Frame* segment_frames)' % identifier)
+    out.append('{')
+    out.extend(lines)
+    out.append('}')
+    out.append('')
+    out.append('itomp_ca_planner::GeneratedFk fk = { "%s", %d, %d, segment_names, fk_%s, NULL };' %
+               (robot_name, num_joints, len(segment_names), identifier))
+    out.append('itomp_ca_planner::GeneratedFkRegistrar registrar(&fk);')
+    out.append('')
+    out.append('}')
+    out.append('')
+
+    with open(sys.argv[2], 'w') as f:
+        f.write('\n'.join(out))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -58,22 +58,24 @@ ContactPoint::~ContactPoint()
 }
 
 void ContactPoint::getPosition(int point, KDL::Vector& position,
-    const std::vector<std::vector<KDL::Frame> >& segmentFrames) const
+    const ContiguousArray2D<KDL::Frame>& segmentFrames) const
 {
   position = segmentFrames[point][linkSegmentNumber_].p;
 }
 
 void ContactPoint::getFrame(int point, KDL::Frame& frame,
-    const std::vector<std::vector<KDL::Frame> >& segmentFrames) const
+    const ContiguousArray2D<KDL::Frame>& segmentFrames) const
 {
   frame = segmentFrames[point][linkSegmentNumber_];
 }
 
 void ContactPoint::updateContactViolationVector(int start, int end, double discretization,
     vector<Vector4d>& contactViolationVector, vector<KDL::Vector>& contactPointVelVector,
-    const vector<vector<KDL::Frame> >& segmentFrames, const planning_scene::PlanningSceneConstPtr& planning_scene) const
+    vector<KDL::Vector>& contactPointPosVector,
+    const ContiguousArray2D<KDL::Frame>& segmentFrames, const planning_scene::PlanningSceneConstPtr& planning_scene) const
 {
-  vector<KDL::Vector> contactPointPosVector(contactViolationVector.size());
+  // contactPointPosVector is a caller-owned scratch buffer, resizing is a no-op once it has the right size
+  contactPointPosVector.resize(contactViolationVector.size());
   for (int i = start; i <= end; ++i)
   {
     KDL::Vector position = segmentFrames[i][linkSegmentNumber_].p;
@@ -105,7 +107,7 @@ void ContactPoint::updateContactViolationVector(int start, int end, double discr
       KDL::Vector::Zero());
 }
 
-double ContactPoint::getDistanceToGround(int point, const std::vector<std::vector<KDL::Frame> >& segmentFrames, const planning_scene::PlanningSceneConstPtr& planning_scene) const
+double ContactPoint::getDistanceToGround(int point, const ContiguousArray2D<KDL::Frame>& segmentFrames, const planning_scene::PlanningSceneConstPtr& planning_scene) const
 {
   KDL::Vector position;
   getPosition(point, position, segmentFrames);
@@ -0,0 +1,433 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#include <itomp_ca_planner/cost/signed_distance_field.h>
+#include <itomp_ca_planner/util/planning_parameters.h>
+#include <geometric_shapes/shapes.h>
+#include <ros/ros.h>
+#include <limits>
+
+namespace itomp_ca_planner
+{
+
+// stands in for infinity in the distance transform, large but still safe to add to
+static const float SDF_FAR = 1e20f;
+
+// upper bound of the number of voxels, the resolution is coarsened above it
+static const long SDF_MAX_VOXELS = 1L << 25;
+
+// axis aligned bounds of the shape in its own frame
+static bool getShapeBounds(const shapes::Shape* shape, Eigen::Vector3d& min, Eigen::Vector3d& max)
+{
+	switch (shape->type)
+	{
+	case shapes::SPHERE:
+	{
+		double r = static_cast<const shapes::Sphere*>(shape)->radius;
+		max = Eigen::Vector3d(r, r, r);
+		min = -max;
+		return true;
+	}
+	case shapes::BOX:
+	{
+		const double* size = static_cast<const shapes::Box*>(shape)->size;
+		max = Eigen::Vector3d(0.5 * size[0], 0.5 * size[1], 0.5 * size[2]);
+		min = -max;
+		return true;
+	}
+	case shapes::CYLINDER:
+	{
+		const shapes::Cylinder* cylinder = static_cast<const shapes::Cylinder*>(shape);
+		max = Eigen::Vector3d(cylinder->radius, cylinder->radius, 0.5 * cylinder->length);
+		min = -max;
+		return true;
+	}
+	case shapes::CONE:
+	{
+		const shapes::Cone* cone = static_cast<const shapes::Cone*>(shape);
+		max = Eigen::Vector3d(cone->radius, cone->radius, 0.5 * cone->length);
+		min = -max;
+		return true;
+	}
+	case shapes::MESH:
+	{
+		const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(shape);
+		if (mesh->vertex_count == 0)
+			return false;
+		min = max = Eigen::Vector3d(mesh->vertices[0], mesh->vertices[1], mesh->vertices[2]);
+		for (unsigned int i = 1; i < mesh->vertex_count; ++i)
+		{
+			Eigen::Vector3d v(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]);
+			min = min.cwiseMin(v);
+			max = max.cwiseMax(v);
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+// point in the shape frame is inside the (primitive) shape
+static bool isInsideShape(const shapes::Shape* shape, const Eigen::Vector3d& p)
+{
+	switch (shape->type)
+	{
+	case shapes::SPHERE:
+	{
+		double r = static_cast<const shapes::Sphere*>(shape)->radius;
+		return p.squaredNorm() <= r * r;
+	}
+	case shapes::BOX:
+	{
+		const double* size = static_cast<const shapes::Box*>(shape)->size;
+		return std::abs(p.x()) <= 0.5 * size[0] && std::abs(p.y()) <= 0.5 * size[1]
+		       && std::abs(p.z()) <= 0.5 * size[2];
+	}
+	case shapes::CYLINDER:
+	{
+		const shapes::Cylinder* cylinder = static_cast<const shapes::Cylinder*>(shape);
+		return std::abs(p.z()) <= 0.5 * cylinder->length
+		       && p.x() * p.x() + p.y() * p.y() <= cylinder->radius * cylinder->radius;
+	}
+	case shapes::CONE:
+	{
+		// the base is at -length / 2
+		const shapes::Cone* cone = static_cast<const shapes::Cone*>(shape);
+		if (std::abs(p.z()) > 0.5 * cone->length)
+			return false;
+		double r = cone->radius * (0.5 - p.z() / cone->length);
+		return p.x() * p.x() + p.y() * p.y() <= r * r;
+	}
+	default:
+		return false;
+	}
+}
+
+// squared euclidean distance transform of a sampled function (Felzenszwalb and Huttenlocher)
+static void distanceTransform1D(const float* f, float* d, int n, int* v, float* z)
+{
+	int k = 0;
+	v[0] = 0;
+	z[0] = -SDF_FAR;
+	z[1] = SDF_FAR;
+	for (int q = 1; q < n; ++q)
+	{
+		double s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]));
+		while (s <= z[k])
+		{
+			--k;
+			s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]));
+		}
+		++k;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = SDF_FAR;
+	}
+
+	k = 0;
+	for (int q = 0; q < n; ++q)
+	{
+		while (z[k + 1] < q)
+			++k;
+		d[q] = (float)(q - v[k]) * (q - v[k]) + f[v[k]];
+	}
+}
+
+SignedDistanceField::SignedDistanceField() :
+	initialized_(false), resolution_(0.0), max_distance_(0.0), origin_(Eigen::Vector3d::Zero())
+{
+	size_[0] = size_[1] = size_[2] = 0;
+}
+
+SignedDistanceField::~SignedDistanceField()
+{
+}
+
+void SignedDistanceField::initialize(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                     const ItompRobotModel& robot_model)
+{
+	ros::WallTime start_time = ros::WallTime::now();
+
+	resolution_ = PlanningParameters::getInstance()->getSDFResolution();
+	computeCollisionSpheres(robot_model);
+
+	// the grid has to cover the clearance around the obstacles for every sphere
+	double max_radius = 0.0;
+	for (std::size_t i = 0; i < collision_spheres_.size(); ++i)
+		max_radius = std::max(max_radius, collision_spheres_[i].radius_);
+	max_distance_ = PlanningParameters::getInstance()->getSDFClearance() + max_radius + 2.0 * resolution_;
+
+	const collision_detection::WorldConstPtr& world = planning_scene->getWorld();
+	std::vector<std::string> object_ids = world->getObjectIds();
+
+	Eigen::Vector3d world_min = Eigen::Vector3d::Constant(std::numeric_limits<double>::max());
+	Eigen::Vector3d world_max = -world_min;
+	for (std::size_t i = 0; i < object_ids.size(); ++i)
+	{
+		collision_detection::World::ObjectConstPtr obj = world->getObject(object_ids[i]);
+		for (std::size_t j = 0; j < obj->shapes_.size(); ++j)
+		{
+			Eigen::Vector3d min, max;
+			if (!getShapeBounds(obj->shapes_[j].get(), min, max))
+			{
+				ROS_WARN("Shape %d of object %s is ignored in the signed distance field", (int) j, object_ids[i].c_str());
+				continue;
+			}
+			for (int c = 0; c < 8; ++c)
+			{
+				Eigen::Vector3d corner((c & 1) ? max.x() : min.x(), (c & 2) ? max.y() : min.y(),
+				                       (c & 4) ? max.z() : min.z());
+				corner = obj->shape_poses_[j] * corner;
+				world_min = world_min.cwiseMin(corner);
+				world_max = world_max.cwiseMax(corner);
+			}
+		}
+	}
+
+	distances_.clear();
+	size_[0] = size_[1] = size_[2] = 0;
+	initialized_ = true;
+	if (world_min.x() > world_max.x())
+		return;
+
+	origin_ = world_min - Eigen::Vector3d::Constant(max_distance_);
+	Eigen::Vector3d extents = world_max - world_min + Eigen::Vector3d::Constant(2.0 * max_distance_);
+	while (true)
+	{
+		long num_voxels = 1;
+		for (int k = 0; k < 3; ++k)
+		{
+			size_[k] = (int)std::ceil(extents(k) / resolution_) + 1;
+			num_voxels *= size_[k];
+		}
+		if (num_voxels <= SDF_MAX_VOXELS)
+			break;
+		resolution_ *= 2.0;
+		ROS_WARN("Signed distance field is too large, resolution is coarsened to %f", resolution_);
+	}
+
+	std::vector<char> occupied(size_[0] * size_[1] * size_[2], 0);
+	for (std::size_t i = 0; i < object_ids.size(); ++i)
+	{
+		collision_detection::World::ObjectConstPtr obj = world->getObject(object_ids[i]);
+		for (std::size_t j = 0; j < obj->shapes_.size(); ++j)
+			voxelizeShape(obj->shapes_[j].get(), obj->shape_poses_[j], occupied);
+	}
+
+	computeDistanceTransform(occupied);
+
+	ROS_INFO("Signed distance field (%d x %d x %d, resolution %f) built in %f sec", size_[0], size_[1], size_[2],
+	         resolution_, (ros::WallTime::now() - start_time).toSec());
+}
+
+void SignedDistanceField::computeCollisionSpheres(const ItompRobotModel& robot_model)
+{
+	collision_spheres_.clear();
+
+	const std::map<std::string, int>& segment_indices =
+		robot_model.getForwardKinematicsSolver()->getSegmentNameToIndex();
+	const std::vector<const robot_model::LinkModel*>& links =
+		robot_model.getRobotModel()->getLinkModelsWithCollisionGeometry();
+	for (std::size_t i = 0; i < links.size(); ++i)
+	{
+		std::map<std::string, int>::const_iterator it = segment_indices.find(links[i]->getName());
+		if (it == segment_indices.end())
+			continue;
+
+		const std::vector<shapes::ShapeConstPtr>& shapes = links[i]->getShapes();
+		for (std::size_t j = 0; j < shapes.size(); ++j)
+		{
+			Eigen::Vector3d min, max;
+			if (!getShapeBounds(shapes[j].get(), min, max))
+				continue;
+
+			// cover the bounding box by spheres along its longest axis
+			Eigen::Vector3d extents = max - min;
+			Eigen::Vector3d center = 0.5 * (min + max);
+			int axis;
+			double length = extents.maxCoeff(&axis);
+			double e1 = extents((axis + 1) % 3);
+			double e2 = extents((axis + 2) % 3);
+			double cross_section = std::max(std::sqrt(e1 * e1 + e2 * e2), resolution_);
+			int num_spheres = std::max(1, (int)std::ceil(length / cross_section));
+			double step = length / num_spheres;
+			double radius = 0.5 * std::sqrt(step * step + e1 * e1 + e2 * e2);
+
+			const Eigen::Affine3d& origin = links[i]->getCollisionOriginTransforms()[j];
+			for (int k = 0; k < num_spheres; ++k)
+			{
+				Eigen::Vector3d local = center;
+				local(axis) += (k + 0.5) * step - 0.5 * length;
+				Eigen::Vector3d position = origin * local;
+
+				CollisionSphere sphere;
+				sphere.segment_index_ = it->second;
+				sphere.center_ = KDL::Vector(position.x(), position.y(), position.z());
+				sphere.radius_ = radius;
+				collision_spheres_.push_back(sphere);
+			}
+		}
+	}
+}
+
+void SignedDistanceField::voxelizeShape(const shapes::Shape* shape, const Eigen::Affine3d& pose,
+                                        std::vector<char>& occupied) const
+{
+	if (shape->type == shapes::MESH)
+	{
+		// meshes are rasterized by their surfaces, the interiors are not filled
+		const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(shape);
+		for (unsigned int t = 0; t < mesh->triangle_count; ++t)
+		{
+			Eigen::Vector3d v[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				unsigned int vi = mesh->triangles[3 * t + k];
+				v[k] = pose * Eigen::Vector3d(mesh->vertices[3 * vi], mesh->vertices[3 * vi + 1],
+				                              mesh->vertices[3 * vi + 2]);
+			}
+			double longest_edge = std::max((v[1] - v[0]).norm(), std::max((v[2] - v[1]).norm(), (v[0] - v[2]).norm()));
+			int n = std::max(1, (int)std::ceil(2.0 * longest_edge / resolution_));
+			for (int a = 0; a <= n; ++a)
+			{
+				for (int b = 0; a + b <= n; ++b)
+				{
+					Eigen::Vector3d p = v[0] + ((double)a / n) * (v[1] - v[0]) + ((double)b / n) * (v[2] - v[0]);
+					int x = (int)std::floor((p.x() - origin_.x()) / resolution_);
+					int y = (int)std::floor((p.y() - origin_.y()) / resolution_);
+					int z = (int)std::floor((p.z() - origin_.z()) / resolution_);
+					if (x >= 0 && y >= 0 && z >= 0 && x < size_[0] && y < size_[1] && z < size_[2])
+						occupied[getIndex(x, y, z)] = 1;
+				}
+			}
+		}
+		return;
+	}
+
+	Eigen::Vector3d min, max;
+	if (!getShapeBounds(shape, min, max))
+		return;
+
+	// voxel range of the world space bounds
+	int begin[3], end[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		begin[k] = size_[k];
+		end[k] = 0;
+	}
+	for (int c = 0; c < 8; ++c)
+	{
+		Eigen::Vector3d corner((c & 1) ? max.x() : min.x(), (c & 2) ? max.y() : min.y(), (c & 4) ? max.z() : min.z());
+		corner = pose * corner;
+		for (int k = 0; k < 3; ++k)
+		{
+			int index = (int)std::floor((corner(k) - origin_(k)) / resolution_);
+			begin[k] = std::min(begin[k], std::max(index, 0));
+			end[k] = std::max(end[k], std::min(index + 1, size_[k]));
+		}
+	}
+
+	Eigen::Affine3d inverse_pose = pose.inverse();
+	for (int z = begin[2]; z < end[2]; ++z)
+	{
+		for (int y = begin[1]; y < end[1]; ++y)
+		{
+			for (int x = begin[0]; x < end[0]; ++x)
+			{
+				Eigen::Vector3d center = origin_ + resolution_ * Eigen::Vector3d(x + 0.5, y + 0.5, z + 0.5);
+				if (isInsideShape(shape, inverse_pose * center))
+					occupied[getIndex(x, y, z)] = 1;
+			}
+		}
+	}
+}
+
+void SignedDistanceField::computeDistanceTransform(const std::vector<char>& occupied)
+{
+	int num_voxels = occupied.size();
+
+	// squared distances to the nearest occupied voxel, and to the nearest free voxel
+	std::vector<float> inside(num_voxels);
+	distances_.resize(num_voxels);
+	for (int i = 0; i < num_voxels; ++i)
+	{
+		distances_[i] = occupied[i] ? 0.0f : SDF_FAR;
+		inside[i] = occupied[i] ? SDF_FAR : 0.0f;
+	}
+	computeSquaredDistances(distances_);
+	computeSquaredDistances(inside);
+
+	// the surface is half a voxel away from the centers of the boundary voxels
+	for (int i = 0; i < num_voxels; ++i)
+	{
+		if (occupied[i])
+			distances_[i] = -(std::sqrt(inside[i]) - 0.5f) * resolution_;
+		else
+			distances_[i] = (std::sqrt(distances_[i]) - 0.5f) * resolution_;
+	}
+}
+
+void SignedDistanceField::computeSquaredDistances(std::vector<float>& grid) const
+{
+	int max_size = std::max(size_[0], std::max(size_[1], size_[2]));
+	std::vector<float> f(max_size), d(max_size), z(max_size + 1);
+	std::vector<int> v(max_size);
+
+	int strides[3] = { 1, size_[0], size_[0] * size_[1] };
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		int n = size_[axis];
+		int stride = strides[axis];
+		int a1 = (axis + 1) % 3;
+		int a2 = (axis + 2) % 3;
+		for (int i = 0; i < size_[a1]; ++i)
+		{
+			for (int j = 0; j < size_[a2]; ++j)
+			{
+				float* line = &grid[i * strides[a1] + j * strides[a2]];
+				for (int q = 0; q < n; ++q)
+					f[q] = line[q * stride];
+				distanceTransform1D(&f[0], &d[0], n, &v[0], &z[0]);
+				for (int q = 0; q < n; ++q)
+					line[q * stride] = d[q];
+			}
+		}
+	}
+}
+
+}
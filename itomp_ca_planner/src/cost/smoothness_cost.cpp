@@ -36,8 +36,6 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 
 */
 #include <itomp_ca_planner/cost/smoothness_cost.h>
-#include <itomp_ca_planner/util/differentiation_rules.h>
-#include <Eigen/LU>
 
 using namespace std;
 using namespace Eigen;
@@ -46,58 +44,44 @@ namespace itomp_ca_planner
 {
 
 SmoothnessCost::SmoothnessCost(const ItompCIOTrajectory& trajectory, int joint_number,
-    const std::vector<double>& derivative_costs, double ridge_factor)
+    const std::vector<double>& derivative_costs, double ridge_factor) :
+    scale_(1.0)
 {
-  int num_vars_all = trajectory.getNumPoints();
-  int num_vars_free = num_vars_all - 2 * (DIFF_RULE_LENGTH - 1);
-  MatrixXd diff_matrix = MatrixXd::Zero(num_vars_all, num_vars_all);
-  quad_cost_full_ = MatrixXd::Zero(num_vars_all, num_vars_all);
-
-  // construct the quad cost for all variables, as a sum of squared differentiation matrices
-  double multiplier = 1.0;
-  for (unsigned int i = 0; i < derivative_costs.size(); i++)
-  {
-    multiplier *= trajectory.getDiscretization();
-    diff_matrix = getDiffMatrix(num_vars_all, &DIFF_RULES[i][0]);
-    quad_cost_full_ += (derivative_costs[i] * multiplier) * (diff_matrix.transpose() * diff_matrix);
-  }
-  quad_cost_full_ += MatrixXd::Identity(num_vars_all, num_vars_all) * ridge_factor;
-
-  // extract the quad cost just for the free variables:
-  quad_cost_ = quad_cost_full_.block(DIFF_RULE_LENGTH - 1, DIFF_RULE_LENGTH - 1, num_vars_free, num_vars_free);
+  joint_cost_ = SmoothnessCostCache::getInstance().getJointCost(trajectory.getNumPoints(),
+      trajectory.getDiscretization(), derivative_costs, ridge_factor);
+}
 
-  // invert the matrix:
-  quad_cost_inv_ = quad_cost_.inverse();
+double SmoothnessCost::getMaxQuadCostInvValue() const
+{
+  return joint_cost_->max_quad_cost_inv_value_ / scale_;
 }
 
-Eigen::MatrixXd SmoothnessCost::getDiffMatrix(int size, const double* diff_rule) const
+void SmoothnessCost::addGradient(const Eigen::Ref<const Eigen::VectorXd>& joint_trajectory, int begin, double weight,
+    Eigen::Ref<Eigen::VectorXd> gradient) const
 {
-  MatrixXd matrix = MatrixXd::Zero(size, size);
-  for (int i = 0; i < size; i++)
+  // d(x^T A x)/dx = 2 A x, the rows of A are read from the band and its transpose
+  const Eigen::MatrixXd& band = joint_cost_->quad_cost_band_;
+  const int num_points = band.cols();
+  const int bandwidth = band.rows() - 1;
+  const double factor = 2.0 * weight * scale_;
+  for (int r = 0; r < gradient.size(); ++r)
   {
-    if (i - DIFF_RULE_LENGTH / 2 < 0 || i + DIFF_RULE_LENGTH / 2 >= size)
-      continue;
-
-    for (int j = -DIFF_RULE_LENGTH / 2; j <= DIFF_RULE_LENGTH / 2; j++)
+    int i = begin + r;
+    double value = band(0, i) * joint_trajectory(i);
+    for (int k = 1; k <= bandwidth; ++k)
     {
-      int index = i + j;
-      matrix(i, index) = diff_rule[j + DIFF_RULE_LENGTH / 2];
+      if (i + k < num_points)
+        value += band(k, i) * joint_trajectory(i + k);
+      if (i - k >= 0)
+        value += band(k, i - k) * joint_trajectory(i - k);
     }
+    gradient(r) += factor * value;
   }
-  return matrix;
-}
-
-double SmoothnessCost::getMaxQuadCostInvValue() const
-{
-  return quad_cost_inv_.maxCoeff();
 }
 
 void SmoothnessCost::scale(double scale)
 {
-  double inv_scale = 1.0 / scale;
-  quad_cost_inv_ *= inv_scale;
-  quad_cost_ *= scale;
-  quad_cost_full_ *= scale;
+  scale_ *= scale;
 }
 
 SmoothnessCost::~SmoothnessCost()
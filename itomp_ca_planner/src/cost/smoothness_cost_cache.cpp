@@ -0,0 +1,232 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#include <itomp_ca_planner/cost/smoothness_cost_cache.h>
+#include <itomp_ca_planner/util/differentiation_rules.h>
+#include <ros/ros.h>
+#include <Eigen/LU>
+
+using namespace std;
+using namespace Eigen;
+
+namespace itomp_ca_planner
+{
+
+namespace
+{
+
+// adds weight * D^T D to the lower band, where D applies the differentiation rule at every row.
+// boundary rows either have their rule clipped to the matrix or are left out
+void addDiffRule(MatrixXd& band, const double* diff_rule, double weight, bool clip_boundary)
+{
+  const int size = band.cols();
+  const int half_length = DIFF_RULE_LENGTH / 2;
+  for (int i = 0; i < size; ++i)
+  {
+    if (!clip_boundary && (i - half_length < 0 || i + half_length >= size))
+      continue;
+
+    int first = std::max(0, i - half_length);
+    int last = std::min(size - 1, i + half_length);
+    for (int c1 = first; c1 <= last; ++c1)
+    {
+      double value = weight * diff_rule[c1 - i + half_length];
+      for (int c2 = c1; c2 <= last; ++c2)
+        band(c2 - c1, c1) += value * diff_rule[c2 - i + half_length];
+    }
+  }
+}
+
+// lower band of the num_vars_free block of the free variables
+MatrixXd getFreeBlockBand(const MatrixXd& band, int num_vars_free)
+{
+  const int bandwidth = band.rows() - 1;
+  MatrixXd free_band = band.block(0, DIFF_RULE_LENGTH - 1, bandwidth + 1, num_vars_free);
+  for (int k = 1; k <= bandwidth; ++k)
+    for (int j = std::max(0, num_vars_free - k); j < num_vars_free; ++j)
+      free_band(k, j) = 0.0;
+  return free_band;
+}
+
+}
+
+SmoothnessCostCache SmoothnessCostCache::instance_;
+
+SmoothnessCostCache::SmoothnessCostCache()
+{
+}
+
+SmoothnessCostCache::JointCostConstPtr SmoothnessCostCache::getJointCost(int num_points, double discretization,
+    const std::vector<double>& derivative_costs, double ridge_factor)
+{
+  std::vector<double> key = makeKey(num_points, discretization, derivative_costs, ridge_factor);
+
+  // entries are built while holding the lock, so threads asking for the same costs wait for a single build
+  boost::lock_guard<boost::mutex> guard(mtx_);
+  if (joint_costs_.size() >= MAX_ENTRIES && joint_costs_.find(key) == joint_costs_.end())
+    joint_costs_.clear();
+  JointCostConstPtr& entry = joint_costs_[key];
+  if (!entry)
+    entry = buildJointCost(num_points, discretization, derivative_costs, ridge_factor);
+  return entry;
+}
+
+SmoothnessCostCache::ControlCostConstPtr SmoothnessCostCache::getControlCost(int num_vars_free, double discretization,
+    const std::vector<double>& derivative_costs, double ridge_factor, bool projection)
+{
+  std::vector<double> key = makeKey(num_vars_free, discretization, derivative_costs, ridge_factor);
+  key.push_back(projection ? 1.0 : 0.0);
+
+  boost::lock_guard<boost::mutex> guard(mtx_);
+  if (control_costs_.size() >= MAX_ENTRIES && control_costs_.find(key) == control_costs_.end())
+    control_costs_.clear();
+  ControlCostConstPtr& entry = control_costs_[key];
+  if (!entry)
+    entry = buildControlCost(num_vars_free, discretization, derivative_costs, ridge_factor, projection);
+  return entry;
+}
+
+void SmoothnessCostCache::clear()
+{
+  boost::lock_guard<boost::mutex> guard(mtx_);
+  joint_costs_.clear();
+  control_costs_.clear();
+}
+
+std::vector<double> SmoothnessCostCache::makeKey(int size, double discretization,
+    const std::vector<double>& derivative_costs, double ridge_factor)
+{
+  std::vector<double> key;
+  key.reserve(derivative_costs.size() + 3);
+  key.push_back(size);
+  key.push_back(discretization);
+  key.push_back(ridge_factor);
+  key.insert(key.end(), derivative_costs.begin(), derivative_costs.end());
+  return key;
+}
+
+SmoothnessCostCache::JointCostConstPtr SmoothnessCostCache::buildJointCost(int num_points, double discretization,
+    const std::vector<double>& derivative_costs, double ridge_factor)
+{
+  const int bandwidth = DIFF_RULE_LENGTH - 1;
+  int num_vars_free = num_points - 2 * (DIFF_RULE_LENGTH - 1);
+
+  // construct the quad cost for all variables, as a sum of squared differentiation matrices
+  MatrixXd band = MatrixXd::Zero(bandwidth + 1, num_points);
+  double multiplier = 1.0;
+  for (unsigned int i = 0; i < derivative_costs.size(); i++)
+  {
+    multiplier *= discretization;
+    addDiffRule(band, &DIFF_RULES[i][0], derivative_costs[i] * multiplier, false);
+  }
+  band.row(0).array() += ridge_factor;
+
+  boost::shared_ptr<JointCost> joint_cost(new JointCost);
+  joint_cost->quad_cost_band_ = band;
+
+  // max coefficient of the inverse of the free variable block, one banded solve per column
+  BandedCholesky cholesky;
+  if (cholesky.compute(getFreeBlockBand(band, num_vars_free)))
+  {
+    double max_value = -std::numeric_limits<double>::max();
+    VectorXd column(num_vars_free);
+    for (int p = 0; p < num_vars_free; ++p)
+    {
+      column.setZero();
+      column(p) = 1.0;
+      cholesky.solveInPlace(column);
+      max_value = std::max(max_value, column.maxCoeff());
+    }
+    joint_cost->max_quad_cost_inv_value_ = max_value;
+  }
+  else
+  {
+    ROS_WARN("Smoothness cost matrix is not positive definite");
+    MatrixXd free_band = getFreeBlockBand(band, num_vars_free);
+    MatrixXd quad_cost = MatrixXd::Zero(num_vars_free, num_vars_free);
+    for (int k = 0; k <= bandwidth; ++k)
+    {
+      for (int j = 0; j + k < num_vars_free; ++j)
+      {
+        quad_cost(j + k, j) = free_band(k, j);
+        quad_cost(j, j + k) = free_band(k, j);
+      }
+    }
+    joint_cost->max_quad_cost_inv_value_ = quad_cost.inverse().maxCoeff();
+  }
+
+  return joint_cost;
+}
+
+SmoothnessCostCache::ControlCostConstPtr SmoothnessCostCache::buildControlCost(int num_vars_free,
+    double discretization, const std::vector<double>& derivative_costs, double ridge_factor, bool projection)
+{
+  const int bandwidth = DIFF_RULE_LENGTH - 1;
+  int num_vars_all = num_vars_free + 2 * (DIFF_RULE_LENGTH - 1);
+
+  // ridge * I + sum_i w_i D_i^T D_i, with D_i clipped at the boundaries
+  MatrixXd band = MatrixXd::Zero(bandwidth + 1, num_vars_all);
+  band.row(0).setConstant(ridge_factor);
+  double multiplier = 1.0;
+  for (unsigned int i = 0; i < derivative_costs.size(); i++)
+  {
+    multiplier /= discretization;
+    addDiffRule(band, &DIFF_RULES[i][0], derivative_costs[i] * multiplier * multiplier, true);
+  }
+
+  boost::shared_ptr<ControlCost> control_cost(new ControlCost);
+  if (!control_cost->cholesky_.compute(getFreeBlockBand(band, num_vars_free)))
+    ROS_ERROR("Control cost matrix is not positive definite");
+
+  // the projection is the inverse control cost with column p scaled to the max num_vars_free^-1
+  if (projection)
+  {
+    control_cost->projection_scales_.resize(num_vars_free);
+    VectorXd column(num_vars_free);
+    for (int p = 0; p < num_vars_free; ++p)
+    {
+      column.setZero();
+      column(p) = 1.0;
+      control_cost->cholesky_.solveInPlace(column);
+      control_cost->projection_scales_(p) = 1.0 / (num_vars_free * column.maxCoeff());
+    }
+  }
+
+  return control_cost;
+}
+
+}
@@ -109,23 +109,13 @@ void TrajectoryCost::init(const EvaluationData* data)
 
 }
 
-void TrajectoryCost::computeCostSum(const EvaluationData* data, Eigen::VectorXd& costData, double& sum)
-{
-  sum = 0.0;
-  for (int i = 1; i <= data->getNumPoints() - 2; i++)
-  {
-    sum += costData(i);
-  }
-}
-
-void TrajectoryCost::compute(const EvaluationData* data, Eigen::VectorXd& costData, double& sum)
+void TrajectoryCost::compute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   doCompute(data, costData);
-  computeCostSum(data, costData, sum);
 }
 ////////////////////////////////////////////////////////////////////////////////
 
-void TrajectorySmoothnessCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectorySmoothnessCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   double smoothness_cost = 0.0;
   // joint costs:
@@ -141,7 +131,7 @@ double TrajectorySmoothnessCost::getWeight() const
 }
 ////////////////////////////////////////////////////////////////////////////////
 
-void TrajectoryCollisionCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectoryCollisionCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   for (int i = 1; i <= data->getNumPoints() - 2; i++)
   {
@@ -155,7 +145,7 @@ double TrajectoryCollisionCost::getWeight() const
 }
 ////////////////////////////////////////////////////////////////////////////////
 
-void TrajectoryValidityCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectoryValidityCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   for (int i = 1; i <= data->getNumPoints() - 2; i++)
   {
@@ -173,7 +163,7 @@ double TrajectoryValidityCost::getWeight() const
 }
 ////////////////////////////////////////////////////////////////////////////////
 
-void TrajectoryContactInvariantCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectoryContactInvariantCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   for (int i = 1; i <= data->getNumPoints() - 2; i++)
   {
@@ -187,7 +177,7 @@ double TrajectoryContactInvariantCost::getWeight() const
 }
 ////////////////////////////////////////////////////////////////////////////////
 
-void TrajectoryPhysicsViolationCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectoryPhysicsViolationCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   for (int i = 1; i <= data->getNumPoints() - 2; i++)
   {
@@ -201,7 +191,7 @@ double TrajectoryPhysicsViolationCost::getWeight() const
 }
 ////////////////////////////////////////////////////////////////////////////////
 
-void TrajectoryGoalPoseCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectoryGoalPoseCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   /*
    double goal_pose_cost = 0.0;
@@ -232,7 +222,7 @@ double TrajectoryGoalPoseCost::getWeight() const
 }
 ////////////////////////////////////////////////////////////////////////////////
 
-void TrajectoryCoMCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectoryCoMCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   /*
    for (int i = evaluator->free_vars_start_; i <= evaluator->free_vars_end_; i++)
@@ -276,7 +266,7 @@ double TrajectoryCoMCost::getWeight() const
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TrajectoryFTRCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectoryFTRCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   for (int i = 1; i <= data->getNumPoints() - 2; i++)
   {
@@ -290,7 +280,7 @@ double TrajectoryFTRCost::getWeight() const
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TrajectoryCartesianCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectoryCartesianCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   for (int i = 0; i < data->getNumPoints(); i++)
   {
@@ -304,7 +294,7 @@ double TrajectoryCartesianCost::getWeight() const
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TrajectorySingularityCost::doCompute(const EvaluationData* data, Eigen::VectorXd& costData)
+void TrajectorySingularityCost::doCompute(const EvaluationData* data, Eigen::MatrixXd::ColXpr costData)
 {
   for (int i = 0; i < data->getNumPoints(); i++)
   {
@@ -38,13 +38,14 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 
 #include <itomp_ca_planner/cost/trajectory_cost_accumulator.h>
 #include <itomp_ca_planner/optimization/evaluation_data.h>
+#include <itomp_ca_planner/util/planning_parameters.h>
 #include <ros/console.h>
 
 namespace itomp_ca_planner
 {
 
 TrajectoryCostAccumulator::TrajectoryCostAccumulator() :
-		is_last_trajectory_valid_(true)
+		costs_(TrajectoryCost::COST_TYPES_NUM), is_last_trajectory_valid_(true)
 {
 	best_cost_ = std::numeric_limits<double>::max();
 }
@@ -58,78 +59,73 @@ void TrajectoryCostAccumulator::addCost(TrajectoryCostPtr cost)
 {
 	if (cost != NULL)
 	{
-		costMap_[cost->getType()] = cost;
+		costs_[cost->getType()] = cost;
 	}
 }
 
 void TrajectoryCostAccumulator::init(const EvaluationData* data)
 {
-	for (std::map<TrajectoryCost::COST_TYPE, TrajectoryCostPtr>::iterator it =
-			costMap_.begin(); it != costMap_.end(); ++it)
+	int num_points = data->getNumPoints();
+	costData_ = Eigen::MatrixXd::Zero(num_points, TrajectoryCost::COST_TYPES_NUM);
+	costSums_ = Eigen::VectorXd::Zero(TrajectoryCost::COST_TYPES_NUM);
+
+	// the weights are read once, a cost with weight 0 is never computed
+	weights_ = Eigen::VectorXd::Zero(TrajectoryCost::COST_TYPES_NUM);
+	waypointWeights_ = Eigen::VectorXd::Zero(TrajectoryCost::COST_TYPES_NUM);
+	activeCostTypes_.clear();
+	for (int i = 0; i < TrajectoryCost::COST_TYPES_NUM; ++i)
 	{
-		it->second->init(data);
-		costDataMap_[it->first] = Eigen::VectorXd::Zero(data->getNumPoints());
-		costSumMap_[it->first] = 0.0;
+		if (costs_[i] == NULL)
+			continue;
+
+		costs_[i]->init(data);
+		double weight = costs_[i]->getWeight();
+		if (weight == 0.0)
+			continue;
+
+		activeCostTypes_.push_back(i);
+		weights_(i) = weight;
+		if (costs_[i]->hasWaypointCosts())
+			waypointWeights_(i) = weight;
 	}
 }
 
 void TrajectoryCostAccumulator::compute(const EvaluationData* data)
 {
-	for (std::map<TrajectoryCost::COST_TYPE, TrajectoryCostPtr>::iterator it =
-			costMap_.begin(); it != costMap_.end(); ++it)
+	for (std::size_t i = 0; i < activeCostTypes_.size(); ++i)
 	{
-		if (it->second->getWeight() != 0.0)
-			it->second->compute(data, costDataMap_[it->first],
-					costSumMap_[it->first]);
+		int type = activeCostTypes_[i];
+		costs_[type]->compute(data, costData_.col(type));
 	}
+	costSums_.noalias() = costData_.middleRows(1, costData_.rows() - 2).colwise().sum().transpose();
 }
 
 double TrajectoryCostAccumulator::getWaypointCost(int waypoint) const
 {
-	double accumulatedCost = 0.0;
-	for (std::map<TrajectoryCost::COST_TYPE, TrajectoryCostPtr>::const_iterator it =
-			costMap_.begin(); it != costMap_.end(); ++it)
-	{
-		const Eigen::VectorXd& costData = costDataMap_.find(it->first)->second;
-		accumulatedCost += it->second->getWaypointCost(waypoint, costData)
-				* it->second->getWeight();
-	}
-	return accumulatedCost;
+	return costData_.row(waypoint).dot(waypointWeights_.transpose());
 }
 
 double TrajectoryCostAccumulator::getWaypointCost(int waypoint,
 		TrajectoryCost::COST_TYPE type) const
 {
-	std::map<TrajectoryCost::COST_TYPE, TrajectoryCostPtr>::const_iterator it =
-			costMap_.find(type);
-	const Eigen::VectorXd& costData = costDataMap_.find(type)->second;
-	return it->second->getWaypointCost(waypoint, costData)
-			* it->second->getWeight();
+	return costData_(waypoint, type) * waypointWeights_(type);
+}
+
+void TrajectoryCostAccumulator::getWaypointCosts(int start, int num_waypoints, Eigen::VectorXd& costs) const
+{
+	// costs(i) = getWaypointCost(start + i) for the first num_waypoints elements
+	costs.head(num_waypoints).noalias() = costData_.middleRows(start, num_waypoints) * waypointWeights_;
 }
 
 double TrajectoryCostAccumulator::getTrajectoryCost(
 		TrajectoryCost::COST_TYPE type) const
 {
-	std::map<TrajectoryCost::COST_TYPE, TrajectoryCostPtr>::const_iterator it =
-			costMap_.find(type);
-	if (it != costMap_.end())
-	{
-		double costSum = costSumMap_.find(it->first)->second;
-		return costSum * it->second->getWeight();
-	}
-	return 0.0;
+	return costSums_(type) * weights_(type);
 }
 
 double TrajectoryCostAccumulator::getTrajectoryCost() const
 {
-	double accumulatedCost = 0.0;
-	for (std::map<TrajectoryCost::COST_TYPE, TrajectoryCostPtr>::const_iterator it =
-			costMap_.begin(); it != costMap_.end(); ++it)
-	{
-		double costSum = costSumMap_.find(it->first)->second;
-		accumulatedCost += costSum * it->second->getWeight();
-	}
-	return accumulatedCost;
+	return costSums_.dot(weights_);
 }
 
 void TrajectoryCostAccumulator::print(int number) const
@@ -160,6 +156,10 @@ bool TrajectoryCostAccumulator::isFeasible() const
 	if (!is_last_trajectory_valid_)
 		return false;
 
+	// the sdf cost is positive within the clearance, the evaluation manager flags the penetrations
+	if (PlanningParameters::getInstance()->getUseSDFCollisionCost())
+		return true;
+
 	if (getTrajectoryCost(TrajectoryCost::COST_COLLISION) < 1E-7)
 		return true;
 
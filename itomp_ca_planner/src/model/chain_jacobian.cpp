@@ -0,0 +1,161 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+
+#include <itomp_ca_planner/model/chain_jacobian.h>
+#include <algorithm>
+
+namespace itomp_ca_planner
+{
+
+ChainJacobian::ChainJacobian() :
+		segment_(-1), num_columns_(0)
+{
+}
+
+bool ChainJacobian::init(const KDL::TreeFkSolverJointPosAxisPartial& fk_solver, int segment,
+		const std::vector<int>& kdl_joints)
+{
+	segment_ = -1;
+	num_columns_ = kdl_joints.size();
+	joints_.clear();
+	columns_.clear();
+	translational_.clear();
+	if (segment < 0 || segment >= fk_solver.getNumSegments())
+		return false;
+
+	segment_ = segment;
+	std::vector<int> ancestor_joints;
+	fk_solver.getAncestorJoints(segment, ancestor_joints);
+	for (int i = 0; i < num_columns_; ++i)
+	{
+		if (std::find(ancestor_joints.begin(), ancestor_joints.end(), kdl_joints[i]) == ancestor_joints.end())
+			continue;
+		joints_.push_back(kdl_joints[i]);
+		columns_.push_back(i);
+		translational_.push_back(fk_solver.isTranslationalJoint(kdl_joints[i]));
+	}
+	return true;
+}
+
+void ChainJacobian::compute(const KDL::Vector* joint_pos, const KDL::Vector* joint_axis,
+		const KDL::Frame* segment_frames, Eigen::MatrixXd& jacobian) const
+{
+	jacobian.setZero(6, num_columns_);
+	const KDL::Vector& position = segment_frames[segment_].p;
+	for (std::size_t k = 0; k < joints_.size(); ++k)
+	{
+		const KDL::Vector& axis = joint_axis[joints_[k]];
+		int c = columns_[k];
+		if (translational_[k])
+		{
+			jacobian(0, c) = axis.x();
+			jacobian(1, c) = axis.y();
+			jacobian(2, c) = axis.z();
+		}
+		else
+		{
+			KDL::Vector velocity = axis * (position - joint_pos[joints_[k]]);
+			jacobian(0, c) = velocity.x();
+			jacobian(1, c) = velocity.y();
+			jacobian(2, c) = velocity.z();
+			jacobian(3, c) = axis.x();
+			jacobian(4, c) = axis.y();
+			jacobian(5, c) = axis.z();
+		}
+	}
+}
+
+void ChainJacobian::computePosition(const KDL::Vector* joint_pos, const KDL::Vector* joint_axis,
+		const KDL::Frame* segment_frames, Eigen::MatrixXd& jacobian) const
+{
+	jacobian.setZero(3, num_columns_);
+	const KDL::Vector& position = segment_frames[segment_].p;
+	for (std::size_t k = 0; k < joints_.size(); ++k)
+	{
+		const KDL::Vector& axis = joint_axis[joints_[k]];
+		KDL::Vector velocity = translational_[k] ? axis : axis * (position - joint_pos[joints_[k]]);
+		int c = columns_[k];
+		jacobian(0, c) = velocity.x();
+		jacobian(1, c) = velocity.y();
+		jacobian(2, c) = velocity.z();
+	}
+}
+
+double ChainJacobian::computeDirectionalManipulability(const KDL::Vector* joint_pos,
+		const KDL::Vector* joint_axis, const KDL::Frame* segment_frames,
+		const KDL::Vector& direction) const
+{
+	// d . (a x (p - o)) == (p - o) . (d x a)
+	const KDL::Vector& position = segment_frames[segment_].p;
+	double sum = 0.0;
+	for (std::size_t k = 0; k < joints_.size(); ++k)
+	{
+		const KDL::Vector& axis = joint_axis[joints_[k]];
+		double v = translational_[k] ?
+				KDL::dot(direction, axis) : KDL::dot(position - joint_pos[joints_[k]], direction * axis);
+		sum += v * v;
+	}
+	return sum;
+}
+
+double ChainJacobian::computeManipulability(const KDL::Vector* joint_pos, const KDL::Vector* joint_axis,
+		const KDL::Frame* segment_frames, Eigen::MatrixXd& jacobian) const
+{
+	compute(joint_pos, joint_axis, segment_frames, jacobian);
+
+	// det(L L^T) == prod(L_ii)^2
+	if (num_columns_ >= 6)
+	{
+		Eigen::Matrix<double, 6, 6> jjt;
+		jjt.noalias() = jacobian * jacobian.transpose();
+		Eigen::LLT<Eigen::Matrix<double, 6, 6> > llt(jjt);
+		if (llt.info() != Eigen::Success)
+			return 0.0;
+		return llt.matrixLLT().diagonal().prod();
+	}
+	else
+	{
+		Eigen::MatrixXd jtj = jacobian.transpose() * jacobian;
+		Eigen::LLT<Eigen::MatrixXd> llt(jtj);
+		if (llt.info() != Eigen::Success)
+			return 0.0;
+		return llt.matrixLLT().diagonal().prod();
+	}
+}
+
+}
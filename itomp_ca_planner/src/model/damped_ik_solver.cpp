@@ -0,0 +1,132 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+
+#include <itomp_ca_planner/model/damped_ik_solver.h>
+
+namespace itomp_ca_planner
+{
+
+const int IK_MAX_ITERATIONS = 200;
+const double IK_POSITION_TOLERANCE = 1e-4; // m
+const double IK_ORIENTATION_TOLERANCE = 1e-3; // rad
+const double IK_DAMPING = 0.05;
+const double IK_MAX_STEP = 0.2; // rad or m of the largest joint change per iteration
+
+DampedIkSolver::DampedIkSolver(const ItompPlanningGroup* planning_group) :
+		planning_group_(planning_group), fk_solver_(*planning_group->fk_solver_)
+{
+	joint_pos_.resize(fk_solver_.getNumJoints());
+	joint_axis_.resize(fk_solver_.getNumJoints());
+	segment_frames_.resize(fk_solver_.getNumSegments());
+}
+
+bool DampedIkSolver::solve(const KDL::Frame& target, KDL::JntArray& q)
+{
+	const ChainJacobian& chain_jacobian = planning_group_->jacobian_;
+	const int segment = chain_jacobian.getSegment();
+	const int num_joints = planning_group_->num_joints_;
+	Eigen::Matrix<double, 6, 1> error;
+	Eigen::Matrix<double, 6, 6> jjt;
+	Eigen::VectorXd dq(num_joints);
+
+	for (int iteration = 0; iteration < IK_MAX_ITERATIONS; ++iteration)
+	{
+		fk_solver_.JntToCartFull(q, joint_pos_, joint_axis_, segment_frames_);
+		const KDL::Frame& frame = segment_frames_[segment];
+
+		// orientation error 1/2 sum(x_i x x_i^d), valid for the small errors of a warm start
+		KDL::Vector position_error = target.p - frame.p;
+		KDL::Vector orientation_error = 0.5
+				* (frame.M.UnitX() * target.M.UnitX() + frame.M.UnitY() * target.M.UnitY()
+						+ frame.M.UnitZ() * target.M.UnitZ());
+		if (position_error.Norm() < IK_POSITION_TOLERANCE && orientation_error.Norm() < IK_ORIENTATION_TOLERANCE)
+			return true;
+		for (int i = 0; i < 3; ++i)
+		{
+			error(i) = position_error(i);
+			error(3 + i) = orientation_error(i);
+		}
+
+		// dq = J^T (J J^T + l^2 I)^-1 e
+		chain_jacobian.compute(&joint_pos_[0], &joint_axis_[0], &segment_frames_[0], jacobian_);
+		jjt.noalias() = jacobian_ * jacobian_.transpose();
+		jjt.diagonal().array() += IK_DAMPING * IK_DAMPING;
+		dq.noalias() = jacobian_.transpose() * jjt.ldlt().solve(error);
+
+		double max_step = dq.cwiseAbs().maxCoeff();
+		if (max_step > IK_MAX_STEP)
+			dq *= IK_MAX_STEP / max_step;
+
+		for (int j = 0; j < num_joints; ++j)
+		{
+			const ItompRobotJoint& joint = planning_group_->group_joints_[j];
+			double value = q(joint.kdl_joint_index_) + dq(j);
+			if (joint.has_joint_limits_)
+				value = std::min(joint.joint_limit_max_, std::max(joint.joint_limit_min_, value));
+			q(joint.kdl_joint_index_) = value;
+		}
+	}
+	return false;
+}
+
+int DampedIkSolver::solvePath(const ItompPlanningGroup* planning_group, const std::vector<KDL::Frame>& targets,
+		const KDL::JntArray& seed, Eigen::MatrixXd& solutions, std::vector<bool>& converged)
+{
+	const int num_waypoints = targets.size();
+	const int num_kdl_joints = seed.rows();
+	solutions.resize(num_waypoints, num_kdl_joints);
+	converged.assign(num_waypoints, false);
+	if (num_waypoints == 0)
+		return 0;
+
+	// each waypoint is warm-started from the solution of the previous one, so the
+	// orientation error stays small and the result does not depend on the thread count
+	DampedIkSolver solver(planning_group);
+	KDL::JntArray q = seed;
+	int num_converged = 0;
+	for (int i = 0; i < num_waypoints; ++i)
+	{
+		converged[i] = solver.solve(targets[i], q);
+		solutions.row(i) = q.data.transpose();
+		if (converged[i])
+			++num_converged;
+	}
+	return num_converged;
+}
+
+}
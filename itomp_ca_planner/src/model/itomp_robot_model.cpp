@@ -38,6 +38,9 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <itomp_ca_planner/model/itomp_robot_model.h>
 #include <kdl_parser/kdl_parser.hpp>
 #include <ros/ros.h>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/variate_generator.hpp>
 #include <visualization_msgs/MarkerArray.h>
 
 using namespace std;
@@ -106,6 +109,21 @@ bool ItompRobotModel::init(robot_model::RobotModelPtr& robot_model, const std::s
     }
   }
 
+  // use the unrolled FK generated for this robot at build time, if it reproduces the KDL tree
+  const GeneratedFk* generated_fk = findGeneratedFk(robot_model_->getName());
+  if (generated_fk != NULL)
+  {
+    if (validateGeneratedFk(*generated_fk))
+    {
+      ROS_INFO("Using the generated forward kinematics of %s", generated_fk->robot_name_);
+    }
+    else
+    {
+      ROS_WARN("Generated forward kinematics of %s does not match the KDL tree, using KDL", generated_fk->robot_name_);
+      generated_fk = NULL;
+    }
+  }
+
   // initialize the planning groups
   std::map<std::string, std::vector<std::string> > groups;
   const std::vector<robot_model::JointModelGroup*>& jointModelGroups = robot_model_->getJointModelGroups();
@@ -133,6 +151,8 @@ bool ItompRobotModel::init(robot_model::RobotModelPtr& robot_model, const std::s
   {
     ItompPlanningGroup group;
     group.name_ = it->first;
+    group.joint_model_group_ =
+        robot_model_->hasJointModelGroup(group.name_) ? robot_model_->getJointModelGroup(group.name_) : NULL;
     ROS_INFO_STREAM("Planning group " << group.name_);
     int num_links = it->second.size();
     group.num_joints_ = 0;
@@ -198,25 +218,39 @@ bool ItompRobotModel::init(robot_model::RobotModelPtr& robot_model, const std::s
     }
     group.fk_solver_.reset(
         new KDL::TreeFkSolverJointPosAxisPartial(kdl_tree_, robot_model_->getRootLinkName(), active_joints));
+    if (generated_fk != NULL)
+      group.fk_solver_->setUnrolledFk(generated_fk->function_);
+    group.batch_fk_solver_.reset(
+        new KDL::TreeFkSolverJointPosAxisBatch(kdl_tree_, robot_model_->getRootLinkName()));
 
     for (int i = 0; i < group.num_joints_; i++)
     {
       group.kdl_to_group_joint_[group.group_joints_[i].kdl_joint_index_] = i;
     }
 
+    // same link as RobotState::getJacobian(group), columns in the group joint order
+    if (group.joint_model_group_ != NULL && !group.joint_model_group_->getLinkModels().empty())
+    {
+      std::vector<int> kdl_joints(group.num_joints_);
+      for (int i = 0; i < group.num_joints_; i++)
+        kdl_joints[i] = group.group_joints_[i].kdl_joint_index_;
+      int segment = group.fk_solver_->segmentNameToIndex(group.joint_model_group_->getLinkModels().back()->getName());
+      group.jacobian_.init(*group.fk_solver_, segment, kdl_joints);
+    }
+
     planning_groups_.insert(make_pair(it->first, group));
   }
 
   // TODO: add contact points to lower body
   if (robot_model->hasLinkModel("left_foot_endeffector_link"))
   {
-    planning_groups_["lower_body"].contactPoints_.push_back(ContactPoint("left_foot_endeffector_link", this));
-    planning_groups_["lower_body"].contactPoints_.push_back(ContactPoint("right_foot_endeffector_link", this));
+    addContactPoint("lower_body", "left_foot_endeffector_link", "left_leg");
+    addContactPoint("lower_body", "right_foot_endeffector_link", "right_leg");
 
-    planning_groups_["whole_body"].contactPoints_.push_back(ContactPoint("left_foot_endeffector_link", this));
-    planning_groups_["whole_body"].contactPoints_.push_back(ContactPoint("right_foot_endeffector_link", this));
-    planning_groups_["whole_body"].contactPoints_.push_back(ContactPoint("left_hand_endeffector_link", this));
-    planning_groups_["whole_body"].contactPoints_.push_back(ContactPoint("right_hand_endeffector_link", this));
+    addContactPoint("whole_body", "left_foot_endeffector_link", "left_leg");
+    addContactPoint("whole_body", "right_foot_endeffector_link", "right_leg");
+    addContactPoint("whole_body", "left_hand_endeffector_link", "left_arm");
+    addContactPoint("whole_body", "right_hand_endeffector_link", "right_arm");
   }
 
   ROS_INFO("Initialized ITOMP robot model in %s reference frame.", reference_frame_.c_str());
@@ -224,6 +258,68 @@ bool ItompRobotModel::init(robot_model::RobotModelPtr& robot_model, const std::s
   return true;
 }
 
+void ItompRobotModel::addContactPoint(const std::string& group_name, const std::string& link_name,
+    const std::string& contact_group_name)
+{
+  ItompPlanningGroup& group = planning_groups_[group_name];
+  group.contactPoints_.push_back(ContactPoint(link_name, this));
+  // the FTR cost uses the jacobian of the group moving the contact point
+  std::map<std::string, ItompPlanningGroup>::const_iterator it = planning_groups_.find(contact_group_name);
+  if (it != planning_groups_.end() && it->second.jacobian_.isValid())
+  {
+    group.contact_jacobians_.push_back(it->second.jacobian_);
+  }
+  else
+  {
+    ROS_WARN("Contact point %s of %s has no group %s", link_name.c_str(), group_name.c_str(),
+             contact_group_name.c_str());
+    group.contact_jacobians_.push_back(ChainJacobian());
+  }
+}
+
+bool ItompRobotModel::validateGeneratedFk(const GeneratedFk& generated_fk) const
+{
+  std::vector<bool> active_joints(num_kdl_joints_, true);
+  KDL::TreeFkSolverJointPosAxisPartial fk_solver(kdl_tree_, robot_model_->getRootLinkName(), active_joints);
+  if (generated_fk.num_joints_ != num_kdl_joints_ || generated_fk.num_segments_ != fk_solver.getNumSegments())
+    return false;
+  const std::vector<std::string> segment_names = fk_solver.getSegmentNames();
+  for (int i = 0; i < generated_fk.num_segments_; ++i)
+  {
+    if (segment_names[i] != generated_fk.segment_names_[i])
+      return false;
+  }
+
+  // compare with KDL at random configurations
+  const double eps = 1e-9;
+  int num_segments = generated_fk.num_segments_;
+  std::vector<KDL::Vector> joint_pos(num_kdl_joints_), joint_axis(num_kdl_joints_);
+  std::vector<KDL::Vector> generated_joint_pos(num_kdl_joints_), generated_joint_axis(num_kdl_joints_);
+  std::vector<KDL::Frame> segment_frames(num_segments), generated_segment_frames(num_segments);
+  KDL::JntArray q(num_kdl_joints_);
+  boost::mt19937 rng;
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<> > random(rng, boost::uniform_real<>(-M_PI, M_PI));
+  for (int trial = 0; trial < 100; ++trial)
+  {
+    for (int j = 0; j < num_kdl_joints_; ++j)
+      q(j) = random();
+    fk_solver.JntToCartFull(q, joint_pos, joint_axis, segment_frames);
+    generated_fk.function_(q.data.data(), &generated_joint_pos[0], &generated_joint_axis[0], &generated_segment_frames[0]);
+    for (int j = 0; j < num_kdl_joints_; ++j)
+    {
+      if (!KDL::Equal(joint_pos[j], generated_joint_pos[j], eps)
+          || !KDL::Equal(joint_axis[j], generated_joint_axis[j], eps))
+        return false;
+    }
+    for (int i = 0; i < num_segments; ++i)
+    {
+      if (!KDL::Equal(segment_frames[i], generated_segment_frames[i], eps))
+        return false;
+    }
+  }
+  return true;
+}
+
 std::string ItompRobotModel::getGroupEndeffectorLinkName(
 		const std::string& group_name) const
 {
@@ -152,14 +152,17 @@ const std::vector<std::string> TreeFkSolverJointPosAxis::getSegmentNames() const
 	return segment_names_;
 }
 
-const std::map<std::string, int> TreeFkSolverJointPosAxis::getSegmentNameToIndex() const
+const std::map<std::string, int>& TreeFkSolverJointPosAxis::getSegmentNameToIndex() const
 {
 	return segment_name_to_index_;
 }
 
-int TreeFkSolverJointPosAxis::segmentNameToIndex(std::string name) const
+int TreeFkSolverJointPosAxis::segmentNameToIndex(const std::string& name) const
 {
-	return segment_name_to_index_.find(name)->second;
+	std::map<std::string, int>::const_iterator it = segment_name_to_index_.find(name);
+	if (it == segment_name_to_index_.end())
+		return -1;
+	return it->second;
 }
 
 } // namespace KDL
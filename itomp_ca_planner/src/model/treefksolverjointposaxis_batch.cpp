@@ -0,0 +1,415 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#include <itomp_ca_planner/model/treefksolverjointposaxis_batch.hpp>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FK_BATCH_X86
+#endif
+
+using namespace std;
+
+namespace KDL
+{
+
+namespace
+{
+
+// T lanes of one SIMD register, double x 4 or float x 8
+template<typename T, int N>
+struct Lanes
+{
+	typedef T Vec __attribute__((vector_size(N * sizeof(T))));
+};
+
+// the vectors are passed by reference, by value they change the ABI with the target ISA (-Wpsabi)
+template<typename V>
+inline __attribute__((always_inline)) void load(V& v, const void* p)
+{
+	memcpy(&v, p, sizeof(v));
+}
+
+template<typename V>
+inline __attribute__((always_inline)) void store(void* p, const V& v)
+{
+	memcpy(p, &v, sizeof(v));
+}
+
+template<typename T, typename V>
+inline __attribute__((always_inline)) void broadcast(V& v, double x)
+{
+	v = V() + (T) x;
+}
+
+// out = a * b, frames as [12] lanes (rotation row-major, then position)
+template<typename V>
+inline __attribute__((always_inline)) void multiplyFrames(const V* a, const V* b, V* out)
+{
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+			out[3 * r + c] = a[3 * r] * b[c] + a[3 * r + 1] * b[3 + c] + a[3 * r + 2] * b[6 + c];
+		out[9 + r] = a[3 * r] * b[9] + a[3 * r + 1] * b[10] + a[3 * r + 2] * b[11] + a[9 + r];
+	}
+}
+
+// the lane loop is the same for every precision and instruction set, only the compiler target differs
+template<typename T, int N>
+inline __attribute__((always_inline)) void batchKernel(const TreeFkSolverJointPosAxisBatch::Tables& t,
+		const T* q_lanes, T* frame_lanes, int num_points, Vector* const* joint_pos,
+		Vector* const* joint_axis, Frame* const* segment_frames)
+{
+	typedef typename Lanes<T, N>::Vec V;
+	V identity[12];
+	for (int k = 0; k < 12; ++k)
+		broadcast<T>(identity[k], (k == 0 || k == 4 || k == 8) ? 1.0 : 0.0);
+	V one;
+	broadcast<T>(one, 1.0);
+
+	for (int i = 0; i < t.num_segments_; ++i)
+	{
+		V parent[12];
+		if (t.parent_nr_[i] == -1)
+		{
+			for (int k = 0; k < 12; ++k)
+				parent[k] = identity[k];
+		}
+		else
+		{
+			const T* parent_lanes = &frame_lanes[t.parent_nr_[i] * 12 * N];
+			for (int k = 0; k < 12; ++k)
+				load(parent[k], parent_lanes + k * N);
+		}
+
+		V pose0[12];
+		for (int k = 0; k < 12; ++k)
+			broadcast<T>(pose0[k], t.pose0_[12 * i + k]);
+
+		V frame[12];
+		int q_nr = t.q_nr_[i];
+		if (t.type_[i] == TreeFkSolverJointPosAxisBatch::SEGMENT_FIXED)
+		{
+			multiplyFrames(parent, pose0, frame);
+		}
+		else
+		{
+			T a[3], o[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				a[k] = t.joint_axis_[3 * q_nr + k];
+				o[k] = t.joint_origin_[3 * q_nr + k];
+			}
+			V q;
+			load(q, q_lanes + q_nr * N);
+
+			// joint position and axis in the parent frame
+			V pos[3], axis[3];
+			for (int r = 0; r < 3; ++r)
+			{
+				pos[r] = parent[3 * r] * o[0] + parent[3 * r + 1] * o[1] + parent[3 * r + 2] * o[2] + parent[9 + r];
+				axis[r] = parent[3 * r] * a[0] + parent[3 * r + 1] * a[1] + parent[3 * r + 2] * a[2];
+			}
+			for (int l = 0; l < num_points; ++l)
+			{
+				joint_pos[l][q_nr] = Vector(pos[0][l], pos[1][l], pos[2][l]);
+				joint_axis[l][q_nr] = Vector(axis[0][l], axis[1][l], axis[2][l]);
+			}
+
+			// joint motion, rotation about the axis through the origin or translation along the axis
+			V motion[12];
+			if (t.type_[i] == TreeFkSolverJointPosAxisBatch::SEGMENT_ROTATIONAL)
+			{
+				T cos_lanes[N], sin_lanes[N];
+				for (int l = 0; l < N; ++l)
+				{
+					cos_lanes[l] = std::cos(q[l]);
+					sin_lanes[l] = std::sin(q[l]);
+				}
+				V c, s;
+				load(c, cos_lanes);
+				load(s, sin_lanes);
+				V v = one - c;
+				motion[0] = c + v * (a[0] * a[0]);
+				motion[1] = v * (a[0] * a[1]) - s * a[2];
+				motion[2] = v * (a[0] * a[2]) + s * a[1];
+				motion[3] = v * (a[1] * a[0]) + s * a[2];
+				motion[4] = c + v * (a[1] * a[1]);
+				motion[5] = v * (a[1] * a[2]) - s * a[0];
+				motion[6] = v * (a[2] * a[0]) - s * a[1];
+				motion[7] = v * (a[2] * a[1]) + s * a[0];
+				motion[8] = c + v * (a[2] * a[2]);
+				for (int r = 0; r < 3; ++r)
+					motion[9 + r] = o[r] - (motion[3 * r] * o[0] + motion[3 * r + 1] * o[1] + motion[3 * r + 2] * o[2]);
+			}
+			else
+			{
+				for (int k = 0; k < 9; ++k)
+					motion[k] = identity[k];
+				for (int r = 0; r < 3; ++r)
+					motion[9 + r] = q * a[r];
+			}
+
+			V moved[12];
+			multiplyFrames(parent, motion, moved);
+			multiplyFrames(moved, pose0, frame);
+		}
+
+		T* lanes = &frame_lanes[i * 12 * N];
+		for (int k = 0; k < 12; ++k)
+			store(lanes + k * N, frame[k]);
+		for (int l = 0; l < num_points; ++l)
+		{
+			Frame& f = segment_frames[l][i];
+			for (int k = 0; k < 9; ++k)
+				f.M.data[k] = lanes[k * N + l];
+			f.p = Vector(lanes[9 * N + l], lanes[10 * N + l], lanes[11 * N + l]);
+		}
+	}
+}
+
+template<typename T, int N>
+void batchKernelGeneric(const TreeFkSolverJointPosAxisBatch::Tables& t, const T* q_lanes,
+		T* frame_lanes, int num_points, Vector* const* joint_pos, Vector* const* joint_axis,
+		Frame* const* segment_frames)
+{
+	batchKernel<T, N>(t, q_lanes, frame_lanes, num_points, joint_pos, joint_axis, segment_frames);
+}
+
+#ifdef FK_BATCH_X86
+template<typename T, int N>
+__attribute__((target("avx2,fma"))) void batchKernelAVX2(const TreeFkSolverJointPosAxisBatch::Tables& t,
+		const T* q_lanes, T* frame_lanes, int num_points, Vector* const* joint_pos,
+		Vector* const* joint_axis, Frame* const* segment_frames)
+{
+	batchKernel<T, N>(t, q_lanes, frame_lanes, num_points, joint_pos, joint_axis, segment_frames);
+}
+#endif
+
+// fills the lanes of q_in, the unused lanes repeat the last point
+template<typename T, int N>
+void loadJointLanes(const JntArray* q_in, int num_points, int num_joints, T* q_lanes)
+{
+	for (int j = 0; j < num_joints; ++j)
+	{
+		for (int l = 0; l < N; ++l)
+			q_lanes[j * N + l] = q_in[std::min(l, num_points - 1)](j);
+	}
+}
+
+bool isClose(const Frame& a, const Frame& b, double eps)
+{
+	for (int k = 0; k < 9; ++k)
+	{
+		if (std::abs(a.M.data[k] - b.M.data[k]) > eps)
+			return false;
+	}
+	return std::abs(a.p.x() - b.p.x()) <= eps && std::abs(a.p.y() - b.p.y()) <= eps
+			&& std::abs(a.p.z() - b.p.z()) <= eps;
+}
+
+}
+
+TreeFkSolverJointPosAxisBatch::TreeFkSolverJointPosAxisBatch() :
+	supported_(false), use_avx2_(false)
+{
+	tables_.num_segments_ = 0;
+	tables_.num_joints_ = 0;
+}
+
+TreeFkSolverJointPosAxisBatch::TreeFkSolverJointPosAxisBatch(const Tree& tree,
+		const std::string& reference_frame) :
+	supported_(true), use_avx2_(false)
+{
+	tables_.num_segments_ = 0;
+	tables_.num_joints_ = tree.getNrOfJoints();
+	tables_.joint_axis_.resize(3 * tables_.num_joints_, 0.0);
+	tables_.joint_origin_.resize(3 * tables_.num_joints_, 0.0);
+
+	// joints numbered like TreeFkSolverJointPosAxisPartial, whose copy of the tree renumbers them depth-first
+	const Tree tree_copy(tree);
+	int reference_nr = -1;
+	buildTables(tree_copy.getRootSegment(), -1, reference_frame, reference_nr);
+	if (reference_nr == -1)
+		reference_nr = 0;
+
+	// the outputs are in the world frame, so the reference frame has to be the identity
+	Frame reference_pose = Frame::Identity();
+	std::vector<int> reference_path;
+	for (int i = reference_nr; i != -1; i = tables_.parent_nr_[i])
+		reference_path.push_back(i);
+	for (int i = reference_path.size() - 1; i >= 0; --i)
+	{
+		int segment_nr = reference_path[i];
+		if (tables_.type_[segment_nr] != SEGMENT_FIXED)
+		{
+			supported_ = false;
+			break;
+		}
+		const double* p = &tables_.pose0_[12 * segment_nr];
+		reference_pose = reference_pose
+				* Frame(Rotation(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8]), Vector(p[9], p[10], p[11]));
+	}
+	if (supported_ && !isClose(reference_pose, Frame::Identity(), 0.0))
+		supported_ = false;
+	if (!supported_)
+		cout << "TreeFkSolverJointPosAxisBatch: the tree is not supported, batch FK is disabled" << endl;
+
+#ifdef FK_BATCH_X86
+	__builtin_cpu_init();
+	use_avx2_ = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+
+	q_lanes_.resize(tables_.num_joints_ * BATCH_SIZE);
+	frame_lanes_.resize(tables_.num_segments_ * 12 * BATCH_SIZE);
+	q_lanes_float_.resize(tables_.num_joints_ * FLOAT_BATCH_SIZE);
+	frame_lanes_float_.resize(tables_.num_segments_ * 12 * FLOAT_BATCH_SIZE);
+}
+
+TreeFkSolverJointPosAxisBatch::~TreeFkSolverJointPosAxisBatch()
+{
+}
+
+bool TreeFkSolverJointPosAxisBatch::setUseAVX2(bool use_avx2)
+{
+	use_avx2_ = false;
+#ifdef FK_BATCH_X86
+	if (use_avx2)
+		use_avx2_ = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	return use_avx2_ == use_avx2;
+}
+
+void TreeFkSolverJointPosAxisBatch::JntToCartFull(const JntArray* q_in, int num_points,
+		Vector* const* joint_pos, Vector* const* joint_axis, Frame* const* segment_frames) const
+{
+	loadJointLanes<double, BATCH_SIZE>(q_in, num_points, tables_.num_joints_, &q_lanes_[0]);
+
+#ifdef FK_BATCH_X86
+	if (use_avx2_)
+	{
+		batchKernelAVX2<double, BATCH_SIZE>(tables_, &q_lanes_[0], &frame_lanes_[0], num_points,
+				joint_pos, joint_axis, segment_frames);
+		return;
+	}
+#endif
+	batchKernelGeneric<double, BATCH_SIZE>(tables_, &q_lanes_[0], &frame_lanes_[0], num_points,
+			joint_pos, joint_axis, segment_frames);
+}
+
+void TreeFkSolverJointPosAxisBatch::JntToCartFullFloat(const JntArray* q_in, int num_points,
+		Vector* const* joint_pos, Vector* const* joint_axis, Frame* const* segment_frames) const
+{
+	loadJointLanes<float, FLOAT_BATCH_SIZE>(q_in, num_points, tables_.num_joints_, &q_lanes_float_[0]);
+
+#ifdef FK_BATCH_X86
+	if (use_avx2_)
+	{
+		batchKernelAVX2<float, FLOAT_BATCH_SIZE>(tables_, &q_lanes_float_[0], &frame_lanes_float_[0],
+				num_points, joint_pos, joint_axis, segment_frames);
+		return;
+	}
+#endif
+	batchKernelGeneric<float, FLOAT_BATCH_SIZE>(tables_, &q_lanes_float_[0], &frame_lanes_float_[0],
+			num_points, joint_pos, joint_axis, segment_frames);
+}
+
+void TreeFkSolverJointPosAxisBatch::buildTables(const SegmentMap::const_iterator this_segment,
+		int parent_nr, const std::string& reference_frame, int& reference_nr)
+{
+	int segment_nr = tables_.num_segments_++;
+	if (this_segment->first == reference_frame)
+		reference_nr = segment_nr;
+
+	const Segment& segment = this_segment->second.segment;
+	Frame pose0 = segment.pose(0.0);
+	tables_.parent_nr_.push_back(parent_nr);
+	for (int k = 0; k < 9; ++k)
+		tables_.pose0_.push_back(pose0.M.data[k]);
+	tables_.pose0_.push_back(pose0.p.x());
+	tables_.pose0_.push_back(pose0.p.y());
+	tables_.pose0_.push_back(pose0.p.z());
+
+	const Joint& joint = segment.getJoint();
+	if (joint.getType() == Joint::None)
+	{
+		tables_.q_nr_.push_back(-1);
+		tables_.type_.push_back(SEGMENT_FIXED);
+	}
+	else
+	{
+		int q_nr = this_segment->second.q_nr;
+		bool rotational = (joint.getType() == Joint::RotAxis || joint.getType() == Joint::RotX
+				|| joint.getType() == Joint::RotY || joint.getType() == Joint::RotZ);
+		Vector axis = joint.JointAxis();
+		Vector origin = joint.JointOrigin();
+		tables_.q_nr_.push_back(q_nr);
+		tables_.type_.push_back(rotational ? SEGMENT_ROTATIONAL : SEGMENT_TRANSLATIONAL);
+		for (int k = 0; k < 3; ++k)
+		{
+			tables_.joint_axis_[3 * q_nr + k] = axis(k);
+			tables_.joint_origin_[3 * q_nr + k] = origin(k);
+		}
+
+		// the kernel assumes joints without scale and offset, compare with KDL
+		const double test_values[] = { -2.1, 0.7, 1.3 };
+		for (int k = 0; k < 3; ++k)
+		{
+			double q = test_values[k];
+			Frame motion;
+			if (rotational)
+			{
+				Rotation rotation = Rotation::Rot2(axis, q);
+				motion = Frame(rotation, origin - rotation * origin);
+			}
+			else
+				motion = Frame(axis * q);
+			if (!isClose(motion * pose0, segment.pose(q), 1e-9))
+				supported_ = false;
+		}
+	}
+
+	for (vector<SegmentMap::const_iterator>::const_iterator child =
+			this_segment->second.children.begin(); child
+			!= this_segment->second.children.end(); child++)
+		buildTables(*child, segment_nr, reference_frame, reference_nr);
+}
+
+} // namespace KDL
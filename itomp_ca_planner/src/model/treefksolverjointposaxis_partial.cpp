@@ -42,14 +42,26 @@ using namespace std;
 namespace KDL
 {
 
+// true only for the exact identity, whose inverse does not change any value
+static bool isIdentity(const Frame& frame)
+{
+	for (int i = 0; i < 9; ++i)
+	{
+		if (frame.M.data[i] != ((i % 4 == 0) ? 1.0 : 0.0))
+			return false;
+	}
+	return frame.p.x() == 0.0 && frame.p.y() == 0.0 && frame.p.z() == 0.0;
+}
+
 TreeFkSolverJointPosAxisPartial::TreeFkSolverJointPosAxisPartial(
 		const Tree& tree, const std::string& reference_frame,
 		const std::vector<bool>& active_joints) :
 	tree_(tree), reference_frame_(reference_frame), active_joints_(
-			active_joints)
+			active_joints), unrolled_fk_(NULL)
 {
 	segment_names_.clear();
 	assignSegmentNumber(tree_.getRootSegment());
+	reference_frame_index_ = 0;
 	std::map<std::string, int>::iterator reference_frame_it =
 			segment_name_to_index_.find(reference_frame);
 	if (reference_frame_it == segment_name_to_index_.end())
@@ -64,14 +76,48 @@ TreeFkSolverJointPosAxisPartial::TreeFkSolverJointPosAxisPartial(
 	}
 	num_segments_ = segment_names_.size();
 	num_joints_ = tree_.getNrOfJoints();
-	segment_frames_.resize(num_segments_);
 	segment_parent_frame_nr_.resize(num_segments_);
-	segment_parent_.resize(num_segments_, NULL);
+	segments_.resize(num_segments_);
+	segment_q_nr_.resize(num_segments_, -1);
+	segment_fixed_pose_.resize(num_segments_, Frame::Identity());
 	joint_parent_frame_nr_.resize(num_joints_);
-	joint_parent_.resize(num_joints_, NULL);
+	joint_segment_nr_.resize(num_joints_, 0);
+	joint_origin_.resize(num_joints_, Vector::Zero());
+	joint_local_axis_.resize(num_joints_, Vector::Zero());
 	segment_evaluation_order_.clear();
-	joint_calc_pos_axis_.clear();
-	joint_calc_pos_axis_.resize(num_joints_, false);
+	segment_dirty_.resize(num_segments_, 0);
+
+	// the tables do not depend on the joint values
+	buildSegmentTables(tree_.getRootSegment(), 0, -1, false);
+
+	// partial FK works in the world frame, composed the same way as in JntToCartFull
+	Frame reference_pose = Frame::Identity();
+	world_is_reference_frame_ = true;
+	std::vector<int> reference_path;
+	for (int i = reference_frame_index_; i != -1; i = segment_parent_frame_nr_[i])
+		reference_path.push_back(i);
+	for (int i = reference_path.size() - 1; i >= 0; --i)
+	{
+		if (segment_q_nr_[reference_path[i]] != -1)
+		{
+			world_is_reference_frame_ = false;
+			break;
+		}
+		reference_pose = reference_pose * segment_fixed_pose_[reference_path[i]];
+	}
+	world_is_reference_frame_ = world_is_reference_frame_ && isIdentity(reference_pose);
+
+	joint_translational_.resize(num_joints_, false);
+	const SegmentMap& segments = tree_.getSegments();
+	for (SegmentMap::const_iterator it = segments.begin(); it != segments.end(); ++it)
+	{
+		const Joint& joint = it->second.segment.getJoint();
+		if (joint.getType() == Joint::None)
+			continue;
+		joint_translational_[it->second.q_nr] = (joint.getType() == Joint::TransAxis
+				|| joint.getType() == Joint::TransX || joint.getType() == Joint::TransY
+				|| joint.getType() == Joint::TransZ);
+	}
 }
 
 TreeFkSolverJointPosAxisPartial::~TreeFkSolverJointPosAxisPartial()
@@ -80,17 +126,60 @@ TreeFkSolverJointPosAxisPartial::~TreeFkSolverJointPosAxisPartial()
 
 int TreeFkSolverJointPosAxisPartial::JntToCartFull(const JntArray& q_in,
 		std::vector<Vector>& joint_pos, std::vector<Vector>& joint_axis,
-		std::vector<Frame>& segment_frames)
+		std::vector<Frame>& segment_frames) const
 {
 	joint_pos.resize(num_joints_);
 	joint_axis.resize(num_joints_);
 	segment_frames.resize(num_segments_);
 
-	segment_evaluation_order_.clear();
+	return JntToCartFull(q_in, &joint_pos[0], &joint_axis[0],
+			&segment_frames[0]);
+}
 
-	// start the recursion
-	treeRecursiveFK(q_in, joint_pos, joint_axis, segment_frames,
-			Frame::Identity(), tree_.getRootSegment(), 0, -1, false);
+int TreeFkSolverJointPosAxisPartial::JntToCartPartial(const JntArray& q_in,
+		const double* q_cached, std::vector<Vector>& joint_pos,
+		std::vector<Vector>& joint_axis, std::vector<Frame>& segment_frames) const
+{
+	joint_pos.resize(num_joints_);
+	joint_axis.resize(num_joints_);
+	segment_frames.resize(num_segments_);
+
+	return JntToCartPartial(q_in, q_cached, &joint_pos[0], &joint_axis[0],
+			&segment_frames[0]);
+}
+
+int TreeFkSolverJointPosAxisPartial::JntToCartFull(const JntArray& q_in,
+		Vector* joint_pos, Vector* joint_axis, Frame* segment_frames) const
+{
+	if (unrolled_fk_ != NULL)
+	{
+		unrolled_fk_(q_in.data.data(), joint_pos, joint_axis, segment_frames);
+		return 0;
+	}
+
+	const Frame identity = Frame::Identity();
+
+	// segments are numbered depth-first, so each parent frame is computed before its children
+	for (int i = 0; i < num_segments_; ++i)
+	{
+		int parent_nr = segment_parent_frame_nr_[i];
+		const Frame& parent_frame = (parent_nr == -1) ? identity : segment_frames[parent_nr];
+		int q_nr = segment_q_nr_[i];
+		if (q_nr == -1)
+		{
+			segment_frames[i] = parent_frame * segment_fixed_pose_[i];
+		}
+		else
+		{
+			joint_pos[q_nr] = parent_frame * joint_origin_[q_nr];
+			joint_axis[q_nr] = parent_frame.M * joint_local_axis_[q_nr];
+			segment_frames[i] = parent_frame * segments_[i].pose(q_in(q_nr));
+		}
+	}
+
+	// the reference frame is usually the root, then there is nothing to convert
+	if (isIdentity(segment_frames[reference_frame_index_]))
+		return 0;
 
 	// get the inverse reference frame:
 	Frame inv_ref_frame = segment_frames[reference_frame_index_].Inverse();
@@ -108,99 +197,91 @@ int TreeFkSolverJointPosAxisPartial::JntToCartFull(const JntArray& q_in,
 		joint_pos[i] = inv_ref_frame * joint_pos[i];
 	}
 
-	segment_frames_ = segment_frames;
-
 	return 0;
 }
 
 int TreeFkSolverJointPosAxisPartial::JntToCartPartial(const JntArray& q_in,
-		std::vector<Vector>& joint_pos, std::vector<Vector>& joint_axis,
-		std::vector<Frame>& segment_frames) const
+		const double* q_cached, Vector* joint_pos, Vector* joint_axis,
+		Frame* segment_frames) const
 {
-	joint_pos.resize(num_joints_);
-	joint_axis.resize(num_joints_);
-	segment_frames.resize(num_segments_);
-
-	// first solve for all segments
-	for (size_t i = 0; i < segment_evaluation_order_.size(); ++i)
+	// only the active joints may change, and the cached values have to be known
+	bool full = !world_is_reference_frame_;
+	for (int i = 0; i < num_joints_ && !full; ++i)
 	{
-		int segment_nr = segment_evaluation_order_[i];
-		const TreeElement* parent_segment = segment_parent_[segment_nr];
-		double jnt_p = 0;
-		if (parent_segment->segment.getJoint().getType() != Joint::None)
-		{
-			jnt_p = q_in(parent_segment->q_nr);
-		}
-
-		segment_frames[segment_nr]
-				= segment_frames[segment_parent_frame_nr_[segment_nr]]
-						* parent_segment->segment.pose(jnt_p);
+		if (q_cached[i] != q_cached[i] || (!active_joints_[i] && q_in(i) != q_cached[i]))
+			full = true;
 	}
+	if (full)
+		return JntToCartFull(q_in, joint_pos, joint_axis, segment_frames);
+
+	const Frame identity = Frame::Identity();
 
-	// now solve for joint positions and axes:
-	for (int i = 0; i < num_joints_; ++i)
+	// the evaluation order is depth-first, so a dirty parent is always visited before its children.
+	// the segments outside the evaluation order are never dirty.
+	for (size_t k = 0; k < segment_evaluation_order_.size(); ++k)
 	{
-		if (joint_calc_pos_axis_[i])
+		int i = segment_evaluation_order_[k];
+		int parent_nr = segment_parent_frame_nr_[i];
+		int q_nr = segment_q_nr_[i];
+		bool parent_dirty = (parent_nr != -1 && segment_dirty_[parent_nr]);
+		bool joint_changed = (q_nr != -1 && q_in(q_nr) != q_cached[q_nr]);
+		segment_dirty_[i] = parent_dirty || joint_changed;
+		if (!segment_dirty_[i])
+			continue;
+
+		const Frame& parent_frame = (parent_nr == -1) ? identity : segment_frames[parent_nr];
+		if (q_nr == -1)
 		{
-			Frame& frame = segment_frames[joint_parent_frame_nr_[i]];
-			const TreeElement* parent_segment = joint_parent_[i];
-			joint_pos[i] = frame
-					* parent_segment->segment.getJoint().JointOrigin();
-			joint_axis[i] = frame.M
-					* parent_segment->segment.getJoint().JointAxis();
+			segment_frames[i] = parent_frame * segment_fixed_pose_[i];
+		}
+		else
+		{
+			if (parent_dirty)
+			{
+				joint_pos[q_nr] = parent_frame * joint_origin_[q_nr];
+				joint_axis[q_nr] = parent_frame.M * joint_local_axis_[q_nr];
+			}
+			segment_frames[i] = parent_frame * segments_[i].pose(q_in(q_nr));
 		}
 	}
 	return 0;
 }
 
-int TreeFkSolverJointPosAxisPartial::treeRecursiveFK(const JntArray& q_in,
-		std::vector<Vector>& joint_pos, std::vector<Vector>& joint_axis,
-		std::vector<Frame>& segment_frames, const Frame& previous_frame,
+int TreeFkSolverJointPosAxisPartial::buildSegmentTables(
 		const SegmentMap::const_iterator this_segment, int segment_nr,
 		int parent_segment_nr, bool active)
 {
-	Frame this_frame = previous_frame;
-
-	// get the joint angle:
-	double jnt_p = 0;
-	if (this_segment->second.segment.getJoint().getType() != Joint::None)
+	const Segment& segment = this_segment->second.segment;
+	segments_[segment_nr] = segment;
+	if (segment.getJoint().getType() == Joint::None)
+	{
+		segment_fixed_pose_[segment_nr] = segment.pose(0.0);
+	}
+	else
 	{
 		int q_nr = this_segment->second.q_nr;
-		jnt_p = q_in(q_nr);
+		segment_q_nr_[segment_nr] = q_nr;
 		joint_parent_frame_nr_[q_nr] = parent_segment_nr;
-		joint_parent_[q_nr] = &(this_segment->second);
-		joint_pos[q_nr] = this_frame
-				* this_segment->second.segment.getJoint().JointOrigin();
-		joint_axis[q_nr] = this_frame.M
-				* this_segment->second.segment.getJoint().JointAxis();
-		if (active && active_joints_[q_nr])
-			joint_calc_pos_axis_[q_nr] = true;
+		joint_segment_nr_[q_nr] = segment_nr;
+		joint_origin_[q_nr] = segment.getJoint().JointOrigin();
+		joint_local_axis_[q_nr] = segment.getJoint().JointAxis();
 		if (active_joints_[q_nr])
 			active = true;
-
-		// TODO:
-		if (segment_nr < 4)
-			active = true;
 	}
 
-	// do the FK:
+	// the segments above the active joints only move with inactive joints,
+	// and JntToCartPartial falls back to JntToCartFull when one of those changes
 	if (active)
 		segment_evaluation_order_.push_back(segment_nr);
 	segment_parent_frame_nr_[segment_nr] = parent_segment_nr;
-	segment_parent_[segment_nr] = &(this_segment->second);
-	this_frame = this_frame * this_segment->second.segment.pose(jnt_p);
-	segment_frames[segment_nr] = this_frame;
 
 	int par_seg_nr = segment_nr;
 	segment_nr++;
 
-	// get poses of child segments
 	for (vector<SegmentMap::const_iterator>::const_iterator child =
 			this_segment->second.children.begin(); child
 			!= this_segment->second.children.end(); child++)
-		segment_nr = treeRecursiveFK(q_in, joint_pos, joint_axis,
-				segment_frames, this_frame, *child, segment_nr, par_seg_nr,
-				active);
+		segment_nr = buildSegmentTables(*child, segment_nr, par_seg_nr, active);
 	return segment_nr;
 }
 
@@ -220,19 +301,43 @@ void TreeFkSolverJointPosAxisPartial::assignSegmentNumber(
 	}
 }
 
+void TreeFkSolverJointPosAxisPartial::getAncestorJoints(int segment_nr,
+		std::vector<int>& joint_nrs) const
+{
+	joint_nrs.clear();
+	SegmentMap::const_iterator root = tree_.getRootSegment();
+	for (SegmentMap::const_iterator it = tree_.getSegment(segment_names_[segment_nr]);
+			it != root; it = it->second.parent)
+	{
+		if (it->second.segment.getJoint().getType() != Joint::None)
+			joint_nrs.push_back(it->second.q_nr);
+	}
+}
+
 const std::vector<std::string> TreeFkSolverJointPosAxisPartial::getSegmentNames() const
 {
 	return segment_names_;
 }
 
-const std::map<std::string, int> TreeFkSolverJointPosAxisPartial::getSegmentNameToIndex() const
+const std::map<std::string, int>& TreeFkSolverJointPosAxisPartial::getSegmentNameToIndex() const
 {
 	return segment_name_to_index_;
 }
 
-int TreeFkSolverJointPosAxisPartial::segmentNameToIndex(std::string name) const
+bool TreeFkSolverJointPosAxisPartial::setUnrolledFk(UnrolledFk unrolled_fk)
+{
+	if (!world_is_reference_frame_)
+		return false;
+	unrolled_fk_ = unrolled_fk;
+	return true;
+}
+
+int TreeFkSolverJointPosAxisPartial::segmentNameToIndex(const std::string& name) const
 {
-	return segment_name_to_index_.find(name)->second;
+	std::map<std::string, int>::const_iterator it = segment_name_to_index_.find(name);
+	if (it == segment_name_to_index_.end())
+		return -1;
+	return it->second;
 }
 
 } // namespace KDL
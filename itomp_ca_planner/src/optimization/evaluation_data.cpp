@@ -44,6 +44,7 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <geometric_shapes/mesh_operations.h>
 #include <geometric_shapes/shape_operations.h>
 #include <geometric_shapes/shapes.h>
+#include <limits>
 
 using namespace std;
 using namespace Eigen;
@@ -51,7 +52,8 @@ using namespace Eigen;
 namespace itomp_ca_planner
 {
 
-EvaluationData::EvaluationData()
+EvaluationData::EvaluationData() :
+    has_evaluated_trajectory_(false)
 {
 
 }
@@ -68,12 +70,20 @@ void EvaluationData::initialize(ItompCIOTrajectory *full_trajectory, ItompCIOTra
 {
   full_trajectory_ = full_trajectory;
   group_trajectory_ = group_trajectory;
+  has_evaluated_trajectory_ = false;
 
   robot_model_ = robot_model;
   planning_scene_ = planning_scene;
   kinematic_state_.resize(getNumParallelThreads());
   for (int i = 0; i < kinematic_state_.size(); ++i)
 	  kinematic_state_[i].reset(new robot_state::RobotState(robot_model->getRobotModel()));
+
+  int num_positions = std::max<int>(kinematic_state_[0]->getVariableCount(), full_trajectory->getNumJoints());
+  thread_scratch_.resize(kinematic_state_.size());
+  for (std::size_t i = 0; i < thread_scratch_.size(); ++i)
+  {
+    thread_scratch_[i].positions_.resize(num_positions);
+  }
   //initStaticEnvironment();
 
   kdl_joint_array_.resize(robot_model->getKDLTree()->getNrOfJoints());
@@ -112,9 +122,11 @@ void EvaluationData::initialize(ItompCIOTrajectory *full_trajectory, ItompCIOTra
     joint_costs_[i].scale(max_cost_scale);
   }
 
-  joint_axis_.resize(num_points, std::vector<KDL::Vector>(robot_model->getKDLTree()->getNrOfJoints()));
-  joint_pos_.resize(num_points, std::vector<KDL::Vector>(robot_model->getKDLTree()->getNrOfJoints()));
-  segment_frames_.resize(num_points, std::vector<KDL::Frame>(robot_model->getKDLTree()->getNrOfSegments()));
+  joint_axis_.resize(num_points, robot_model->getKDLTree()->getNrOfJoints());
+  joint_pos_.resize(num_points, robot_model->getKDLTree()->getNrOfJoints());
+  segment_frames_.resize(num_points, robot_model->getKDLTree()->getNrOfSegments());
+  fk_joint_values_.resize(num_points, robot_model->getKDLTree()->getNrOfJoints(),
+                          std::numeric_limits<double>::quiet_NaN());
 
   state_is_in_collision_.resize(num_points);
 
@@ -130,24 +142,16 @@ void EvaluationData::initialize(ItompCIOTrajectory *full_trajectory, ItompCIOTra
   stateCartesianTrajectoryCost_.resize(num_points);
   stateSingularityCost_.resize(num_points);
 
-  linkPositions_.resize(num_mass_segments);
-  linkVelocities_.resize(num_mass_segments);
-  linkAngularVelocities_.resize(num_mass_segments);
-  for (int i = 0; i < num_mass_segments; ++i)
-  {
-    linkPositions_[i].resize(num_points);
-    linkVelocities_[i].resize(num_points);
-    linkAngularVelocities_[i].resize(num_points);
-  }
+  linkPositions_.resize(num_mass_segments, num_points);
+  linkVelocities_.resize(num_mass_segments, num_points);
+  linkAngularVelocities_.resize(num_mass_segments, num_points);
   CoMPositions_.resize(num_points);
   CoMVelocities_.resize(num_points);
   CoMAccelerations_.resize(num_points);
   AngularMomentums_.resize(num_points);
   Torques_.resize(num_points);
   wrenchSum_.resize(num_points);
-  contact_forces_.resize(num_points);
-  for (int i = 0; i < num_points; ++i)
-    contact_forces_[i].resize(num_contacts);
+  contact_forces_.resize(num_points, num_contacts, KDL::Vector::Zero());
 
   // init values to 0
   for (int i = 0; i < num_points; ++i)
@@ -158,17 +162,22 @@ void EvaluationData::initialize(ItompCIOTrajectory *full_trajectory, ItompCIOTra
     AngularMomentums_[i] = KDL::Vector::Zero();
     Torques_[i] = KDL::Vector::Zero();
     wrenchSum_[i] = KDL::Wrench::Zero();
-    for (int j = 0; j < num_contacts; ++j)
-      contact_forces_[i][j] = KDL::Vector::Zero();
   }
 
-  contactViolationVector_.resize(num_contacts);
-  contactPointVelVector_.resize(num_contacts);
-  for (int i = 0; i < num_contacts; ++i)
-  {
-    contactViolationVector_[i].resize(num_points);
-    contactPointVelVector_[i].resize(num_points);
-  }
+  contactViolationVector_.resize(num_contacts, num_points);
+  contactPointVelVector_.resize(num_contacts, num_points);
+  contact_ftr_costs_.resize(num_contacts, num_points);
+  for (std::size_t i = 0; i < thread_scratch_.size(); ++i)
+    thread_scratch_[i].contact_point_positions_.resize(num_points);
+
+  // enough for every point of the buffers recorded by a derivative evaluation (FK also writes the last point)
+  int num_segments = robot_model->getKDLTree()->getNrOfSegments();
+  int num_kdl_joints = robot_model->getKDLTree()->getNrOfJoints();
+  std::size_t journal_point_size = num_segments * sizeof(KDL::Frame) + 2 * num_kdl_joints * sizeof(KDL::Vector)
+      + num_kdl_joints * sizeof(double)
+      + 2 * sizeof(int) + 3 * sizeof(double) + num_contacts * sizeof(double)
+      + (num_mass_segments + 3) * sizeof(KDL::Vector);
+  journal_.reserve(journal_point_size * (num_points + 1), 20 + num_contacts + num_mass_segments);
 
   costAccumulator_.addCost(TrajectoryCost::CreateTrajectoryCost(TrajectoryCost::COST_SMOOTHNESS));
   costAccumulator_.addCost(TrajectoryCost::CreateTrajectoryCost(TrajectoryCost::COST_COLLISION));
@@ -182,6 +191,18 @@ void EvaluationData::initialize(ItompCIOTrajectory *full_trajectory, ItompCIOTra
   costAccumulator_.init(this);
 
   fk_solver_ = *planning_group->fk_solver_.get();
+  for (std::size_t i = 0; i < thread_scratch_.size(); ++i)
+  {
+    thread_scratch_[i].fk_solver_ = fk_solver_;
+    thread_scratch_[i].kdl_joint_array_.resize(robot_model->getKDLTree()->getNrOfJoints());
+    if (PlanningParameters::getInstance()->getUseBatchForwardKinematics()
+        || PlanningParameters::getInstance()->getUseFloatRolloutEvaluation())
+    {
+      thread_scratch_[i].batch_fk_solver_ = *planning_group->batch_fk_solver_.get();
+      thread_scratch_[i].batch_joint_arrays_.resize(KDL::TreeFkSolverJointPosAxisBatch::FLOAT_BATCH_SIZE,
+                                                    KDL::JntArray(robot_model->getKDLTree()->getNrOfJoints()));
+    }
+  }
 
   cartesian_waypoints_.resize(path_constraints.position_constraints.size());
   for (int i = 0; i < path_constraints.position_constraints.size(); ++i)
@@ -263,21 +284,30 @@ EvaluationData* EvaluationData::clone() const
   EvaluationData* new_data = new EvaluationData();
 
   *new_data = *this;
-
-  new_data->group_trajectory_ = new ItompCIOTrajectory(*group_trajectory_);
-  new_data->full_trajectory_ = new ItompCIOTrajectory(*full_trajectory_);
-
-  for (int i = 0; i < kinematic_state_.size(); ++i)
-	  new_data->kinematic_state_[i].reset(new robot_state::RobotState(robot_model_->getRobotModel()));
+  new_data->allocateOwnTrajectories();
 
   return new_data;
 }
 
+void EvaluationData::allocateOwnTrajectories()
+{
+  // replace the shared trajectories and robot states by copies owned by this data
+  own_group_trajectory_.reset(new ItompCIOTrajectory(*group_trajectory_));
+  own_full_trajectory_.reset(new ItompCIOTrajectory(*full_trajectory_));
+  group_trajectory_ = own_group_trajectory_.get();
+  full_trajectory_ = own_full_trajectory_.get();
+
+  for (std::size_t i = 0; i < kinematic_state_.size(); ++i)
+    kinematic_state_[i].reset(new robot_state::RobotState(robot_model_->getRobotModel()));
+}
+
 void EvaluationData::deepCopy(const EvaluationData& data)
 {
   // store pointers
   ItompCIOTrajectory* group_trajectory = group_trajectory_;
   ItompCIOTrajectory* full_trajectory = full_trajectory_;
+  boost::shared_ptr<ItompCIOTrajectory> own_group_trajectory = own_group_trajectory_;
+  boost::shared_ptr<ItompCIOTrajectory> own_full_trajectory = own_full_trajectory_;
   std::vector<robot_state::RobotStatePtr> kinematic_state = kinematic_state_;
 
   // copy
@@ -290,6 +320,8 @@ void EvaluationData::deepCopy(const EvaluationData& data)
   // copy pointers again
   group_trajectory_ = group_trajectory;
   full_trajectory_ = full_trajectory;
+  own_group_trajectory_ = own_group_trajectory;
+  own_full_trajectory_ = own_full_trajectory;
 
   // do not copy planning scene
   kinematic_state_ = kinematic_state;
@@ -371,9 +403,9 @@ void EvaluationData::compare(const EvaluationData& ref) const
   }
   // segment frame
   {
-    for (int i = 0; i < segment_frames_.size(); ++i)
+    for (int i = 0; i < segment_frames_.rows(); ++i)
     {
-      for (int j = 0; j < segment_frames_[0].size(); ++j)
+      for (int j = 0; j < segment_frames_.cols(); ++j)
       {
         if (segment_frames_[i][j] != ref.segment_frames_[i][j])
         {
@@ -411,9 +443,9 @@ void EvaluationData::compare(const EvaluationData& ref) const
 
   // contact violation vec
   {
-    for (int i = 0; i < contactViolationVector_.size(); ++i)
+    for (int i = 0; i < contactViolationVector_.rows(); ++i)
     {
-      for (int j = 0; j < contactViolationVector_[0].size(); ++j)
+      for (int j = 0; j < contactViolationVector_.cols(); ++j)
       {
         for (int k = 0; k < 4; ++k)
         {
@@ -432,9 +464,9 @@ void EvaluationData::compare(const EvaluationData& ref) const
 
   // contact violation vec
   {
-    for (int i = 0; i < contactPointVelVector_.size(); ++i)
+    for (int i = 0; i < contactPointVelVector_.rows(); ++i)
     {
-      for (int j = 0; j < contactPointVelVector_[0].size(); ++j)
+      for (int j = 0; j < contactPointVelVector_.cols(); ++j)
       {
         if (contactPointVelVector_[i][j] != ref.contactPointVelVector_[i][j])
         {
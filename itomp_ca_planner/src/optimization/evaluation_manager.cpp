@@ -40,15 +40,20 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <moveit_msgs/PlanningScene.h>
 #include <itomp_ca_planner/optimization/evaluation_manager.h>
 #include <itomp_ca_planner/model/itomp_planning_group.h>
+#include <itomp_ca_planner/model/damped_ik_solver.h>
 #include <itomp_ca_planner/contact/ground_manager.h>
 #include <itomp_ca_planner/visualization/visualization_manager.h>
 #include <itomp_ca_planner/contact/contact_force_solver.h>
+#include <itomp_ca_planner/cost/signed_distance_field.h>
 #include <itomp_ca_planner/util/min_jerk_trajectory.h>
 #include <itomp_ca_planner/util/planning_parameters.h>
 #include <itomp_ca_planner/util/vector_util.h>
 #include <itomp_ca_planner/util/multivariate_gaussian.h>
+#include <itomp_ca_planner/util/allocation_counter.h>
+#include <itomp_ca_planner/util/undo_journal.h>
 #include <visualization_msgs/MarkerArray.h>
 #include <iostream>
+#include <limits>
 
 using namespace std;
 using namespace Eigen;
@@ -62,7 +67,8 @@ static int LeftLegStart = 0;
 static bool STABILITY_COST_VERBOSE = false;
 
 EvaluationManager::EvaluationManager(int* iteration) :
-    iteration_(iteration), data_(&default_data_), count_(0)
+    iteration_(iteration), data_(&default_data_), single_precision_(false), count_(0),
+    last_evaluation_allocation_count_(0)
 {
 	print_debug_texts_ = false;
 }
@@ -72,6 +78,27 @@ EvaluationManager::~EvaluationManager()
 
 }
 
+EvaluationManager* EvaluationManager::clone() const
+{
+	// the new manager shares the robot model and the planning group,
+	// but evaluates on its own copy of the current data and trajectories
+	EvaluationManager* new_manager = new EvaluationManager(*this);
+	if (data_ != &default_data_)
+		new_manager->default_data_ = *data_;
+	new_manager->default_data_.allocateOwnTrajectories();
+	new_manager->setDataToDefault();
+
+	return new_manager;
+}
+
+void EvaluationManager::setSinglePrecision(bool single_precision)
+{
+	// the frames of the other precision must not be reused by incremental evaluation
+	if (single_precision != single_precision_)
+		data_->has_evaluated_trajectory_ = false;
+	single_precision_ = single_precision;
+}
+
 void EvaluationManager::initialize(ItompCIOTrajectory *full_trajectory,
                                    ItompCIOTrajectory *group_trajectory, ItompRobotModel *robot_model,
                                    const ItompPlanningGroup *planning_group, double planning_start_time,
@@ -88,6 +115,22 @@ void EvaluationManager::initialize(ItompCIOTrajectory *full_trajectory,
 	planning_group_ = planning_group;
 	robot_name_ = robot_model_->getRobotName();
 
+	// the cost terms only see the segment numbers
+	cartesian_tool_segment_ = robot_model_->getSegmentIndex(
+			PlanningParameters::getInstance()->getCartesianTrajectoryToolLink());
+	cartesian_flange_segment_ = robot_model_->getSegmentIndex(
+			PlanningParameters::getInstance()->getCartesianTrajectoryFlangeLink());
+	if (PlanningParameters::getInstance()->getCartesianTrajectoryCostWeight() != 0.0)
+	{
+		if (cartesian_tool_segment_ == -1 && path_constraints.position_constraints.size() != 0)
+			ROS_ERROR("Cartesian trajectory tool link %s is not in the robot model",
+					PlanningParameters::getInstance()->getCartesianTrajectoryToolLink().c_str());
+		if (cartesian_flange_segment_ == -1
+				&& (path_constraints.position_constraints.size() != 0 || planning_group_->name_ == "lower_body"))
+			ROS_WARN("Cartesian trajectory flange link %s is not in the robot model",
+					PlanningParameters::getInstance()->getCartesianTrajectoryFlangeLink().c_str());
+	}
+
 	// init some variables:
 	num_joints_ = group_trajectory->getNumJoints();
 	num_contacts_ = group_trajectory->getNumContacts();
@@ -106,6 +149,12 @@ void EvaluationManager::initialize(ItompCIOTrajectory *full_trajectory,
 
 	is_collision_free_ = false;
 	last_trajectory_collision_free_ = false;
+	exact_collision_check_pending_ = false;
+
+	collision_cache_.reset();
+	if (PlanningParameters::getInstance()->getUseCollisionCache())
+		collision_cache_.reset(new CollisionCache(PlanningParameters::getInstance()->getCollisionCacheCapacity(),
+				PlanningParameters::getInstance()->getCollisionCacheQuantum()));
 
     vis_marker_pub_ = VisualizationManager::getInstance()->getVisualizationMarkerPublisher();
     vis_marker_array_pub_ = VisualizationManager::getInstance()->getVisualizationMarkerArrayPublisher();
@@ -118,6 +167,25 @@ void EvaluationManager::initialize(ItompCIOTrajectory *full_trajectory,
                              planning_group, this, num_mass_segments_, path_constraints,
                              planning_scene);
 
+	// joints moving each segment, used in the analytic gradients
+	kdl_joint_to_group_joint_index_.clear();
+	kdl_joint_to_group_joint_index_.resize(robot_model_->getKDLTree()->getNrOfJoints(), -1);
+	for (int i = 0; i < num_joints_; ++i)
+		kdl_joint_to_group_joint_index_[group_joint_to_kdl_joint_index_[i]] = i;
+	const KDL::TreeFkSolverJointPosAxisPartial& fk_solver = default_data_.fk_solver_;
+	segment_group_joints_.clear();
+	segment_group_joints_.resize(fk_solver.getNumSegments());
+	std::vector<int> ancestor_joints;
+	for (int i = 0; i < fk_solver.getNumSegments(); ++i)
+	{
+		fk_solver.getAncestorJoints(i, ancestor_joints);
+		for (std::size_t j = 0; j < ancestor_joints.size(); ++j)
+		{
+			if (kdl_joint_to_group_joint_index_[ancestor_joints[j]] != -1)
+				segment_group_joints_[i].push_back(ancestor_joints[j]);
+		}
+	}
+
 	timings_.resize(100, 0);
 	for (int i = 0; i < 100; ++i)
 		timings_[i] = 0;
@@ -141,12 +209,27 @@ void EvaluationManager::initialize(ItompCIOTrajectory *full_trajectory,
 
 double EvaluationManager::evaluate()
 {
+    INIT_ALLOCATION_COUNT
     INIT_TIME_MEASUREMENT(10)
 
     ADD_TIMER_POINT
 
+	bool incremental = PlanningParameters::getInstance()->getUseIncrementalEvaluation()
+			&& computeDirtyRanges();
+
+	// the sdf and cached collision flags are approximate, checkLastTrajectoryFeasibility() confirms them with FCL
+	exact_collision_check_pending_ = (PlanningParameters::getInstance()->getUseSDFCollisionCost() || collision_cache_)
+			&& PlanningParameters::getInstance()->getObstacleCostWeight() != 0.0;
+
 	// do forward kinematics:
-	last_trajectory_collision_free_ = performForwardKinematics();
+	if (incremental)
+	{
+		last_trajectory_collision_free_ = true;
+		for (std::size_t r = 0; r < dirty_ranges_.size(); ++r)
+			last_trajectory_collision_free_ &= performForwardKinematics(dirty_ranges_[r].first, dirty_ranges_[r].second);
+	}
+	else
+		last_trajectory_collision_free_ = performForwardKinematics();
 
     ADD_TIMER_POINT
 
@@ -157,13 +240,47 @@ double EvaluationManager::evaluate()
 
     ADD_TIMER_POINT
 
-	// TODO: reuse
-	computeCollisionCosts();
+	if (incremental)
+	{
+		for (std::size_t r = 0; r < dirty_ranges_.size(); ++r)
+		{
+			computeCollisionCosts(max(dirty_ranges_[r].first, full_vars_start_ + 1),
+					min(dirty_ranges_[r].second, full_vars_end_ - 1));
+		}
+		// collisions of the points which are not recomputed
+		for (int i = full_vars_start_ + 1; i < full_vars_end_ - 1; ++i)
+		{
+			if (data_->state_is_in_collision_[i])
+				last_trajectory_collision_free_ = false;
+		}
+	}
+	else
+		computeCollisionCosts();
 
     ADD_TIMER_POINT
 
 	//computeFTRs();
-	computeSingularityCosts();
+	if (incremental)
+	{
+		for (std::size_t r = 0; r < dirty_ranges_.size(); ++r)
+		{
+			computeSingularityCosts(max(dirty_ranges_[r].first, full_vars_start_ + 1),
+					min(dirty_ranges_[r].second, full_vars_end_ - 1));
+		}
+	}
+	else
+		computeSingularityCosts();
+
+	if (PlanningParameters::getInstance()->getUseIncrementalEvaluation())
+	{
+		if (incremental)
+		{
+			for (std::size_t r = 0; r < dirty_ranges_.size(); ++r)
+				updateEvaluatedTrajectory(dirty_ranges_[r].first, dirty_ranges_[r].second);
+		}
+		else
+			updateEvaluatedTrajectory(0, num_points_);
+	}
 
     ADD_TIMER_POINT
 
@@ -183,9 +300,75 @@ double EvaluationManager::evaluate()
     UPDATE_TIME
     //PRINT_TIME(evaluate, 10)
 
+	// buffers are sized by the first evaluation, the later ones should not allocate
+	last_evaluation_allocation_count_ = GET_ALLOCATION_COUNT;
+
 	return data_->costAccumulator_.getTrajectoryCost();
 }
 
+bool EvaluationManager::computeDirtyRanges()
+{
+	// returns false if the whole trajectory needs to be evaluated
+	dirty_ranges_.clear();
+	if (!data_->has_evaluated_trajectory_)
+		return false;
+
+	if (getGroupTrajectory()->getContactTrajectory() != data_->evaluated_contact_trajectory_)
+		return false;
+
+	const Eigen::MatrixXd& trajectory = getGroupTrajectory()->getTrajectory();
+	const Eigen::MatrixXd& evaluated_trajectory = data_->evaluated_group_trajectory_;
+	const double tolerance = PlanningParameters::getInstance()->getIncrementalEvaluationTolerance();
+
+	// changed points are extended by the half length of the differentiation rule
+	const int halo = DIFF_RULE_LENGTH / 2;
+	for (int i = 0; i < num_points_; ++i)
+	{
+		bool changed = false;
+		for (int j = 0; j < num_joints_; ++j)
+		{
+			if (fabs(trajectory(i, j) - evaluated_trajectory(i, j)) > tolerance)
+			{
+				changed = true;
+				break;
+			}
+		}
+		if (!changed)
+			continue;
+
+		int begin = max(0, i - halo);
+		int end = min(num_points_, i + halo + 1);
+		if (!dirty_ranges_.empty() && dirty_ranges_.back().second >= begin)
+			dirty_ranges_.back().second = end;
+		else
+			dirty_ranges_.push_back(std::make_pair(begin, end));
+	}
+
+	return true;
+}
+
+void EvaluationManager::resetIncrementalEvaluation()
+{
+	data_->has_evaluated_trajectory_ = false;
+}
+
+void EvaluationManager::updateEvaluatedTrajectory(int begin, int end)
+{
+	if (!data_->has_evaluated_trajectory_)
+	{
+		data_->evaluated_group_trajectory_ = getGroupTrajectory()->getTrajectory();
+		data_->evaluated_contact_trajectory_ = getGroupTrajectory()->getContactTrajectory();
+		data_->has_evaluated_trajectory_ = true;
+		return;
+	}
+
+	// only the recomputed points are updated, so the points skipped within the tolerance
+	// are recomputed when their total change exceeds the tolerance
+	data_->evaluated_group_trajectory_.block(begin, 0, end - begin, num_joints_) =
+			getGroupTrajectory()->getTrajectory().block(begin, 0, end - begin, num_joints_);
+	data_->evaluated_contact_trajectory_ = getGroupTrajectory()->getContactTrajectory();
+}
+
 double EvaluationManager::evaluate(Eigen::VectorXd& costs)
 {
 	double ret = evaluate();
@@ -195,10 +378,7 @@ double EvaluationManager::evaluate(Eigen::VectorXd& costs)
 	// TODO
 	int num_vars_free = num_points_ - 10 - 2;
 	int start = 6;
-	for (int i = 0; i < num_vars_free; i++)
-	{
-		costs(i) = data_->costAccumulator_.getWaypointCost(start + i);
-	}
+	data_->costAccumulator_.getWaypointCosts(start, num_vars_free, costs);
 
 	return ret;
 }
@@ -214,7 +394,9 @@ double EvaluationManager::evaluate(DERIVATIVE_VARIABLE_TYPE variable_type,
 
 	// do forward kinematics:
 	if (variable_type != DERIVATIVE_CONTACT_VARIABLE)
+	{
 		performForwardKinematics(begin, end);
+	}
 
 	ADD_TIMER_POINT
 
@@ -231,6 +413,9 @@ double EvaluationManager::evaluate(DERIVATIVE_VARIABLE_TYPE variable_type,
 
 	computeFTRs(begin, end);
 
+	if (variable_type != DERIVATIVE_CONTACT_VARIABLE)
+		computeSingularityCosts(begin, end);
+
 	data_->costAccumulator_.compute(data_);
 
 	UPDATE_TIME
@@ -261,22 +446,20 @@ void EvaluationManager::setTrajectory(const Eigen::MatrixXd& parameters,
 }
 
 void EvaluationManager::setTrajectory(
-    const std::vector<Eigen::VectorXd>& parameters,
-    const std::vector<Eigen::VectorXd>& contact_parameters)
+    const Eigen::Ref<const Eigen::MatrixXd>& parameters,
+    const Eigen::Ref<const Eigen::MatrixXd>& contact_parameters)
 {
 	// copy the parameters into group_trajectory:
-	int cols = getGroupTrajectory()->getTrajectory().cols();
 	for (int d = 0; d < num_joints_; ++d)
 	{
-		getGroupTrajectory()->getFreeJointTrajectoryBlock(d) = parameters[d];
+		getGroupTrajectory()->getFreeJointTrajectoryBlock(d) = parameters.col(d);
 	}
 
-	cols = num_contact_points_;
 	for (int d = 0; d < num_contacts_; ++d)
 	{
 		//getGroupTrajectory()->getContactTrajectory().block(i, 0, 1, cols) = contact_parameters[i];
 		getGroupTrajectory()->getFreeContactTrajectoryBlock(d) =
-            contact_parameters[d];
+            contact_parameters.col(d);
 	}
 
 	//getGroupTrajectory()->updateTrajectoryFromFreePoints();
@@ -308,7 +491,7 @@ void EvaluationManager::backupAndSetVariables(double new_value,
 		target_trajectory = &getGroupTrajectory()->getContactTrajectory();
 		break;
 	}
-	backup_data_.trajectory_value_ = (*target_trajectory)(free_point_index,
+	backup_trajectory_value_ = (*target_trajectory)(free_point_index,
                                      joint_index);
 
 	ROS_ASSERT(
@@ -328,90 +511,8 @@ void EvaluationManager::backupAndSetVariables(double new_value,
 		updateFullTrajectory(free_point_index, joint_index);
 	}
 
-	int stride = getGroupTrajectory()->getContactPhaseStride();
-	if (free_point_index == 0)
-		free_point_index = 1;
-	int begin = (free_point_index - 1) * stride;
-
-	backup_data_.segment_frames_.resize(2 * stride);
-
-	backup_data_.wrenchSum_.resize(2 * stride + 1);
-	backup_data_.linkPositions_.resize(num_mass_segments_);
-	backup_data_.linkVelocities_.resize(num_mass_segments_);
-	backup_data_.linkAngularVelocities_.resize(num_mass_segments_);
-	for (int i = 0; i < num_mass_segments_; ++i)
-	{
-		backup_data_.linkPositions_[i].resize(2 * stride + 1);
-		backup_data_.linkVelocities_[i].resize(2 * stride + 1);
-		backup_data_.linkAngularVelocities_[i].resize(2 * stride + 1);
-	}
-	backup_data_.CoMPositions_.resize(2 * stride + 1);
-	backup_data_.CoMVelocities_.resize(2 * stride + 1);
-	backup_data_.CoMAccelerations_.resize(2 * stride + 1);
-	backup_data_.AngularMomentums_.resize(2 * stride + 1);
-	backup_data_.Torques_.resize(2 * stride + 1);
-	backup_data_.contactViolationVector_.resize(num_contacts_);
-	backup_data_.contactPointVelVector_.resize(num_contacts_);
-	for (int i = 0; i < num_contacts_; ++i)
-	{
-		backup_data_.contactViolationVector_[i].resize(2 * stride + 1);
-		backup_data_.contactPointVelVector_[i].resize(2 * stride + 1);
-	}
-
-	backup_data_.state_contact_invariant_cost_.resize(2 * stride + 1);
-	backup_data_.state_physics_violation_cost_.resize(2 * stride + 1);
-	backup_data_.state_collision_cost_.resize(2 * stride);
-	backup_data_.state_ftr_cost_.resize(2 * stride);
-
-	for (int i = 0; i < 2 * stride; ++i)
-	{
-		backup_data_.segment_frames_[i] = data_->segment_frames_[begin + i];
-	}
-
-	memcpy(&backup_data_.wrenchSum_[0], &data_->wrenchSum_[begin],
-           sizeof(KDL::Wrench) * 2 * stride + 1);
-	for (int i = 0; i < num_mass_segments_; ++i)
-	{
-		memcpy(&backup_data_.linkPositions_[i][0],
-               &data_->linkPositions_[i][begin],
-               sizeof(KDL::Vector) * 2 * stride + 1);
-		memcpy(&backup_data_.linkVelocities_[i][0],
-               &data_->linkVelocities_[i][begin],
-               sizeof(KDL::Vector) * 2 * stride + 1);
-		memcpy(&backup_data_.linkAngularVelocities_[i][0],
-               &data_->linkAngularVelocities_[i][begin],
-               sizeof(KDL::Vector) * 2 * stride + 1);
-	}
-	memcpy(&backup_data_.CoMPositions_[0], &data_->CoMPositions_[begin],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	memcpy(&backup_data_.CoMVelocities_[0], &data_->CoMVelocities_[begin],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	memcpy(&backup_data_.CoMAccelerations_[0], &data_->CoMAccelerations_[begin],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	memcpy(&backup_data_.AngularMomentums_[0], &data_->AngularMomentums_[begin],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	memcpy(&backup_data_.Torques_[0], &data_->Torques_[begin],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	for (int i = 0; i < num_contacts_; ++i)
-	{
-		memcpy(&backup_data_.contactViolationVector_[i][0],
-               &data_->contactViolationVector_[i][begin],
-               sizeof(Vector4d) * 2 * stride + 1);
-		memcpy(&backup_data_.contactPointVelVector_[i][0],
-               &data_->contactPointVelVector_[i][begin],
-               sizeof(KDL::Vector) * 2 * stride + 1);
-	}
-
-	memcpy(&backup_data_.state_contact_invariant_cost_[0],
-           &data_->stateContactInvariantCost_[begin],
-           sizeof(double) * 2 * stride + 1);
-	memcpy(&backup_data_.state_physics_violation_cost_[0],
-           &data_->statePhysicsViolationCost_[begin],
-           sizeof(double) * 2 * stride + 1);
-	memcpy(&backup_data_.state_collision_cost_[0],
-           &data_->stateCollisionCost_[begin], sizeof(double) * 2 * stride);
-	memcpy(&backup_data_.state_ftr_cost_[0], &data_->stateFTRCost_[begin],
-           sizeof(double) * 2 * stride + 1);
+	// the stages of the partial evaluation record what they overwrite
+	data_->journal_.checkpoint();
 }
 
 void EvaluationManager::restoreVariable(DERIVATIVE_VARIABLE_TYPE variable_type,
@@ -435,67 +536,15 @@ void EvaluationManager::restoreVariable(DERIVATIVE_VARIABLE_TYPE variable_type,
 
 	// restore trajectory value
 	(*target_trajectory)(free_point_index, joint_index) =
-        backup_data_.trajectory_value_;
+        backup_trajectory_value_;
 	if (variable_type != DERIVATIVE_CONTACT_VARIABLE)
 	{
 		getGroupTrajectory()->updateTrajectoryFromFreePoint(free_point_index,
 				joint_index);
 		updateFullTrajectory(free_point_index, joint_index);
 	}
-	// restore variables
-	int stride = getGroupTrajectory()->getContactPhaseStride();
-	if (free_point_index == 0)
-		free_point_index = 1;
-	int begin = (free_point_index - 1) * stride;
-
-	for (int i = 0; i < 2 * stride; ++i)
-		data_->segment_frames_[begin + i] = backup_data_.segment_frames_[i];
-
-	memcpy(&data_->wrenchSum_[begin], &backup_data_.wrenchSum_[0],
-           sizeof(KDL::Wrench) * 2 * stride + 1);
-	for (int i = 0; i < num_mass_segments_; ++i)
-	{
-		memcpy(&data_->linkPositions_[i][begin],
-               &backup_data_.linkPositions_[i][0],
-               sizeof(KDL::Vector) * 2 * stride + 1);
-		memcpy(&data_->linkVelocities_[i][begin],
-               &backup_data_.linkVelocities_[i][0],
-               sizeof(KDL::Vector) * 2 * stride + 1);
-		memcpy(&data_->linkAngularVelocities_[i][begin],
-               &backup_data_.linkAngularVelocities_[i][0],
-               sizeof(KDL::Vector) * 2 * stride + 1);
-	}
-	memcpy(&data_->CoMPositions_[begin], &backup_data_.CoMPositions_[0],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	memcpy(&data_->CoMVelocities_[begin], &backup_data_.CoMVelocities_[0],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	memcpy(&data_->CoMAccelerations_[begin], &backup_data_.CoMAccelerations_[0],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	memcpy(&data_->AngularMomentums_[begin], &backup_data_.AngularMomentums_[0],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	memcpy(&data_->Torques_[begin], &backup_data_.Torques_[0],
-           sizeof(KDL::Vector) * 2 * stride + 1);
-	for (int i = 0; i < num_contacts_; ++i)
-	{
-		memcpy(&data_->contactViolationVector_[i][begin],
-               &backup_data_.contactViolationVector_[i][0],
-               sizeof(Vector4d) * 2 * stride + 1);
-		memcpy(&data_->contactPointVelVector_[i][begin],
-               &backup_data_.contactPointVelVector_[i][0],
-               sizeof(KDL::Vector) * 2 * stride + 1);
-	}
-
-	memcpy(&data_->stateContactInvariantCost_[begin],
-           &backup_data_.state_contact_invariant_cost_[0],
-           sizeof(double) * 2 * stride + 1);
-	memcpy(&data_->statePhysicsViolationCost_[begin],
-           &backup_data_.state_physics_violation_cost_[0],
-           sizeof(double) * 2 * stride + 1);
-	memcpy(&data_->stateCollisionCost_[begin],
-           &backup_data_.state_collision_cost_[0],
-           sizeof(double) * 2 * stride);
-	memcpy(&data_->stateFTRCost_[begin], &backup_data_.state_ftr_cost_[0],
-           sizeof(double) * 2 * stride + 1);
+	// restore the buffers overwritten by the partial evaluation
+	data_->journal_.rollback();
 }
 
 double EvaluationManager::evaluateDerivatives(double value,
@@ -505,6 +554,9 @@ double EvaluationManager::evaluateDerivatives(double value,
 	// backup old values and update trajectory
 	backupAndSetVariables(value, variable_type, free_point_index, joint_index);
 
+	// the partial evaluation below does not keep the incremental evaluation state
+	data_->has_evaluated_trajectory_ = false;
+
 	// evaluate
 	double cost = evaluate(variable_type, free_point_index, joint_index);
 
@@ -513,6 +565,224 @@ double EvaluationManager::evaluateDerivatives(double value,
 	return cost;
 }
 
+double EvaluationManager::evaluateGradient(Eigen::MatrixXd& gradient)
+{
+	// updates the frames, joint positions and joint axes of all points
+	double cost = evaluate();
+
+	// d(cost)/d(free point, joint) of the smoothness, collision and cartesian trajectory costs
+	gradient.setZero(getGroupTrajectory()->getNumFreePoints(), num_joints_);
+	computeSmoothnessGradient(gradient);
+	computeCollisionGradient(gradient);
+	computeCartesianTrajectoryGradient(gradient);
+
+	return cost;
+}
+
+void EvaluationManager::computeSmoothnessGradient(Eigen::MatrixXd& gradient)
+{
+	double weight = PlanningParameters::getInstance()->getSmoothnessCostWeight();
+	if (weight == 0.0)
+		return;
+
+	int start = getGroupTrajectory()->getStartIndex();
+	for (int j = 0; j < num_joints_; ++j)
+		data_->joint_costs_[j].addGradient(getGroupTrajectory()->getJointTrajectory(j), start, weight, gradient.col(j));
+}
+
+void EvaluationManager::computeCollisionGradient(Eigen::MatrixXd& gradient)
+{
+	double weight = PlanningParameters::getInstance()->getObstacleCostWeight();
+	if (weight == 0.0)
+		return;
+
+	if (PlanningParameters::getInstance()->getUseSDFCollisionCost())
+	{
+		computeSDFCollisionGradient(weight, gradient);
+		return;
+	}
+
+	int num_all_joints = data_->kinematic_state_[0]->getVariableCount();
+	const std::map<std::string, int>& segment_name_to_index = data_->fk_solver_.getSegmentNameToIndex();
+
+	collision_detection::CollisionRequest collision_request;
+	collision_request.verbose = false;
+	collision_request.contacts = true;
+	collision_request.max_contacts = 1000;
+
+	int start = getGroupTrajectory()->getStartIndex();
+	int end = min(start + (int) gradient.rows(), num_points_);
+	#pragma omp parallel for
+	for (int i = start; i < end; ++i)
+	{
+		// the depth is zero (and so is its gradient) unless the point is in collision
+		if (!data_->state_is_in_collision_[i])
+			continue;
+
+		int thread_num = omp_get_thread_num();
+		std::vector<double>& positions = data_->thread_scratch_[thread_num].positions_;
+		collision_detection::CollisionResult& collision_result = data_->thread_scratch_[thread_num].collision_result_;
+
+		int full_traj_index = getGroupTrajectory()->getFullTrajectoryIndex(i);
+		for (int k = 0; k < num_all_joints; k++)
+			positions[k] = (*getFullTrajectory())(full_traj_index, k);
+		data_->kinematic_state_[thread_num]->setVariablePositions(&positions[0]);
+		data_->planning_scene_->checkCollisionUnpadded(collision_request, collision_result,
+				*data_->kinematic_state_[thread_num]);
+
+		const collision_detection::CollisionResult::ContactMap& contact_map = collision_result.contacts;
+		for (collision_detection::CollisionResult::ContactMap::const_iterator it = contact_map.begin(); it != contact_map.end(); ++it)
+		{
+			const collision_detection::Contact& contact = it->second[0];
+			KDL::Vector position(contact.pos(0), contact.pos(1), contact.pos(2));
+			KDL::Vector normal(contact.normal(0), contact.normal(1), contact.normal(2));
+
+			// the normal points from the first body to the second one,
+			// so the depth grows when the first body moves along the normal
+			std::map<std::string, int>::const_iterator segment_it;
+			if (contact.body_type_1 == collision_detection::BodyTypes::ROBOT_LINK
+					&& (segment_it = segment_name_to_index.find(contact.body_name_1)) != segment_name_to_index.end())
+				addSegmentPositionGradient(i, segment_it->second, position, normal, weight, gradient);
+			if (contact.body_type_2 == collision_detection::BodyTypes::ROBOT_LINK
+					&& (segment_it = segment_name_to_index.find(contact.body_name_2)) != segment_name_to_index.end())
+				addSegmentPositionGradient(i, segment_it->second, position, -normal, weight, gradient);
+		}
+		collision_result.clear();
+	}
+}
+
+// follows the sphere costs of computeSDFCollisionCosts()
+void EvaluationManager::computeSDFCollisionGradient(double weight, Eigen::MatrixXd& gradient)
+{
+	const SignedDistanceField* sdf = SignedDistanceField::getInstance();
+	const std::vector<SignedDistanceField::CollisionSphere>& spheres = sdf->getCollisionSpheres();
+	double clearance = PlanningParameters::getInstance()->getSDFClearance();
+
+	int start = getGroupTrajectory()->getStartIndex();
+	int begin = max(start, full_vars_start_ + 1);
+	int end = min(start + (int) gradient.rows(), full_vars_end_ - 1);
+	#pragma omp parallel for
+	for (int i = begin; i < end; ++i)
+	{
+		const KDL::Frame* frames = data_->segment_frames_[i];
+		for (std::size_t s = 0; s < spheres.size(); ++s)
+		{
+			const SignedDistanceField::CollisionSphere& sphere = spheres[s];
+			KDL::Vector position = frames[sphere.segment_index_] * sphere.center_;
+			KDL::Vector distance_gradient;
+			double distance = sdf->getDistance(position, distance_gradient) - sphere.radius_;
+
+			// d(cost)/d(distance) of the penetrating and the close spheres
+			double cost_derivative;
+			if (distance < 0.0)
+				cost_derivative = -1.0;
+			else if (distance < clearance)
+				cost_derivative = (distance - clearance) / clearance;
+			else
+				continue;
+			addSegmentPositionGradient(i, sphere.segment_index_, position, distance_gradient,
+					weight * cost_derivative, gradient);
+		}
+	}
+}
+
+void EvaluationManager::computeCartesianTrajectoryGradient(Eigen::MatrixXd& gradient)
+{
+	double weight = PlanningParameters::getInstance()->getCartesianTrajectoryCostWeight();
+	if (weight == 0.0)
+		return;
+
+	// follows the cost terms of computeCartesianTrajectoryCosts()
+	if (data_->cartesian_waypoints_.size() != 0)
+	{
+		const int END_EFFECTOR_SEGMENT_INDEX = cartesian_tool_segment_;
+		if (END_EFFECTOR_SEGMENT_INDEX == -1)
+			return;
+
+		KDL::Vector start_pos = data_->cartesian_waypoints_[0].p;
+		KDL::Vector end_pos = data_->cartesian_waypoints_[1].p;
+
+		int num_vars_free = 100;
+		int point_index = 6;
+		for (int i = point_index; i < point_index + num_vars_free; ++i)
+		{
+			const KDL::Frame& frame = data_->segment_frames_[i][END_EFFECTOR_SEGMENT_INDEX];
+			double t = (double)(i - (point_index - 1)) / (num_vars_free);
+			KDL::Vector cartesian_pos = start_pos * (1.0 - t) + end_pos * t;
+
+			// d|p - c|^2 = 2 (p - c) . dp
+			addSegmentPositionGradient(i, END_EFFECTOR_SEGMENT_INDEX, frame.p, frame.p - cartesian_pos, 2.0 * weight,
+					gradient);
+		}
+	}
+	else
+	{
+		if (planning_group_->name_ != "lower_body")
+			return;
+
+		const int END_EFFECTOR_SEGMENT_INDEX = cartesian_flange_segment_;
+		if (END_EFFECTOR_SEGMENT_INDEX == -1)
+			return;
+		const KDL::Vector down(0, 0, -1);
+
+		int num_vars_free = 100;
+		int point_index = 5;
+		for (int i = point_index; i < point_index + num_vars_free; ++i)
+		{
+			const KDL::Frame& frame = data_->segment_frames_[i][END_EFFECTOR_SEGMENT_INDEX];
+			KDL::Vector y_dir = frame.M.UnitY();
+			double dot = KDL::dot(y_dir, down);
+			if (dot >= 1.0 || dot <= -1.0)
+				continue;
+
+			double angle = acos(dot);
+			double scale = (angle > 5.0 * M_PI / 180.0) ? 1.0 : 0.1;
+
+			// d(s * angle^2) = 2 s angle * d(acos(dot)) = -2 s angle / sqrt(1 - dot^2) * d(dot)
+			addSegmentRotationGradient(i, END_EFFECTOR_SEGMENT_INDEX, y_dir, down,
+					-2.0 * weight * scale * angle / sqrt(1.0 - dot * dot), gradient);
+		}
+	}
+}
+
+void EvaluationManager::addSegmentPositionGradient(int point, int segment, const KDL::Vector& position,
+		const KDL::Vector& direction, double scale, Eigen::MatrixXd& gradient) const
+{
+	// adds scale * direction . d(position)/dq for the group joints moving the segment
+	int row = point - getGroupTrajectoryConst()->getStartIndex();
+	if (row < 0 || row >= gradient.rows())
+		return;
+
+	const std::vector<int>& joints = segment_group_joints_[segment];
+	for (std::size_t k = 0; k < joints.size(); ++k)
+	{
+		int kdl_joint = joints[k];
+		const KDL::Vector& axis = data_->joint_axis_[point][kdl_joint];
+		KDL::Vector velocity = data_->fk_solver_.isTranslationalJoint(kdl_joint) ?
+				axis : axis * (position - data_->joint_pos_[point][kdl_joint]);
+		gradient(row, kdl_joint_to_group_joint_index_[kdl_joint]) += scale * KDL::dot(direction, velocity);
+	}
+}
+
+void EvaluationManager::addSegmentRotationGradient(int point, int segment, const KDL::Vector& vector,
+		const KDL::Vector& direction, double scale, Eigen::MatrixXd& gradient) const
+{
+	// adds scale * direction . d(vector)/dq for a vector fixed in the segment frame
+	int row = point - getGroupTrajectoryConst()->getStartIndex();
+	if (row < 0 || row >= gradient.rows())
+		return;
+
+	const std::vector<int>& joints = segment_group_joints_[segment];
+	for (std::size_t k = 0; k < joints.size(); ++k)
+	{
+		int kdl_joint = joints[k];
+		if (data_->fk_solver_.isTranslationalJoint(kdl_joint))
+			continue;
+		KDL::Vector velocity = data_->joint_axis_[point][kdl_joint] * vector;
+		gradient(row, kdl_joint_to_group_joint_index_[kdl_joint]) += scale * KDL::dot(direction, velocity);
+	}
+}
+
 void EvaluationManager::render(int trajectory_index, bool is_best)
 {
 	if (PlanningParameters::getInstance()->getAnimatePath())
@@ -530,10 +800,11 @@ void EvaluationManager::render(int trajectory_index, bool is_best)
 
 void EvaluationManager::computeMassAndGravityForce()
 {
+	// the segments with a mass are looked up once, computeCoM only reads this table
 	total_mass_ = 0.0;
+	mass_segments_.clear();
 	const KDL::SegmentMap& segmentMap =
         robot_model_->getKDLTree()->getSegments();
-	num_mass_segments_ = 0;
 	for (KDL::SegmentMap::const_iterator it = segmentMap.begin();
 			it != segmentMap.end(); ++it)
 	{
@@ -543,16 +814,19 @@ void EvaluationManager::computeMassAndGravityForce()
 			continue;
 
 		total_mass_ += mass;
-		masses_.push_back(mass);
-
-		++num_mass_segments_;
+		MassSegment mass_segment;
+		mass_segment.segment_index_ = robot_model_->getForwardKinematicsSolver()->segmentNameToIndex(it->first);
+		mass_segment.mass_ = mass;
+		mass_segment.cog_ = segment.getInertia().getCOG();
+		mass_segments_.push_back(mass_segment);
 	}
+	num_mass_segments_ = mass_segments_.size();
 	gravity_force_ = total_mass_ * KDL::Vector(0.0, 0.0, -9.8);
 
 	// normalize gravity force to 1.0 and rescale masses
 	gravity_force_ = KDL::Vector(0.0, 0.0, -1.0);
-	for (int i = 0; i < masses_.size(); ++i)
-		masses_[i] /= total_mass_ * 9.8;
+	for (int i = 0; i < num_mass_segments_; ++i)
+		mass_segments_[i].mass_ /= total_mass_ * 9.8;
 	total_mass_ = 1.0 / 9.8;
 
 }
@@ -587,16 +861,12 @@ void EvaluationManager::handleJointLimits()
 
 void EvaluationManager::handleTrajectoryConstraint()
 {
-	if (data_->cartesian_waypoints_.size() == 0)
+	if (data_->cartesian_waypoints_.size() == 0 || cartesian_flange_segment_ == -1
+			|| !planning_group_->jacobian_.isValid())
 		return;
 
 	// TODO: temp
 	// handle cartesian traj
-	robot_state::RobotStatePtr kinematic_state(
-        new robot_state::RobotState(robot_model_->getRobotModel()));
-	const robot_state::JointModelGroup* joint_model_group =
-        robot_model_->getRobotModel()->getJointModelGroup(planning_group_->name_);
-
 	KDL::Vector start_pos = data_->cartesian_waypoints_[0].p;
 	KDL::Vector end_pos = data_->cartesian_waypoints_[1].p;
 	KDL::Vector dir = (end_pos - start_pos);
@@ -605,81 +875,45 @@ void EvaluationManager::handleTrajectoryConstraint()
 
 	int start = 6;
 
-	Eigen::Matrix3d mat;
-	for (int i = 0; i < 3; ++i)
-		for (int j = 0; j < 3; ++j)
-			mat(i, j) = orientation(i, j);
-
-	// set state to the start config
-	std::vector<double> positions(num_joints_);
-	for (std::size_t k = 0; k < num_joints_; k++)
-	{
-		positions[k] = (*getGroupTrajectory())(5, k);
-	}
-	kinematic_state->setVariablePositions(&positions[0]);
-	kinematic_state->update();
-
-	const int END_EFFECTOR_SEGMENT_INDEX =
-        robot_model_->getForwardKinematicsSolver()->segmentNameToIndex(
-            "segment_7");
+	const int END_EFFECTOR_SEGMENT_INDEX = cartesian_flange_segment_;
 	int num_vars_free = num_points_ - 10 - 2;
 
+	std::vector<KDL::Frame> targets(num_vars_free);
 	for (int i = start; i < start + num_vars_free; i++)
 	{
-		int full_traj_index = getGroupTrajectory()->getFullTrajectoryIndex(i);
-
-		for (std::size_t k = 0; k < num_joints_; k++)
-			positions[k] = (*getGroupTrajectory())(i, k);
-		kinematic_state->setVariablePositions(&positions[0]);
-		kinematic_state->update();
-
-		KDL::Frame& frame =
-            data_->segment_frames_[i][END_EFFECTOR_SEGMENT_INDEX];
 		KDL::Vector proj = start_pos
-                           + KDL::dot(dir, (frame.p - start_pos)) * dir;
-		if (KDL::dot((proj - start_pos), dir) < 0)
-			proj = start_pos;
-		if (KDL::dot((proj - end_pos), dir) > 0)
-			proj = end_pos;
-
-		proj = start_pos
                + (end_pos - start_pos) * (double) (i - start) / num_vars_free;
+		targets[i - start] = KDL::Frame(orientation, proj);
+	}
 
-		double dist = (frame.p - proj).Norm();
-
-		// Use IK to compute joint values
-		vector<double> ik_solution(num_joints_);
-
-		Eigen::Affine3d end_effector_state = Eigen::Affine3d::Identity();
-		Eigen::Vector3d trans(proj.x(), proj.y(), proj.z());
-
-		end_effector_state.linear() = mat;
-		end_effector_state.translation() = trans;
-
-		kinematics::KinematicsQueryOptions options;
-		options.return_approximate_solution = false;
-		bool found_ik = kinematic_state->setFromIK(joint_model_group,
-                        end_effector_state, 10, 0.1,
-                        moveit::core::GroupStateValidityCallbackFn(), options);
-		if (found_ik)
+	// seeded from the config before the constrained part
+	int num_kdl_joints = getFullTrajectory()->getNumJoints();
+	KDL::JntArray seed(num_kdl_joints);
+	int seed_index = getGroupTrajectory()->getFullTrajectoryIndex(start - 1);
+	for (int k = 0; k < num_kdl_joints; k++)
+		seed(k) = (*getFullTrajectory())(seed_index, k);
+
+	// Use IK to compute joint values
+	Eigen::MatrixXd ik_solutions;
+	std::vector<bool> converged;
+	int num_converged = DampedIkSolver::solvePath(planning_group_, targets, seed, ik_solutions, converged);
+	for (int i = start; i < start + num_vars_free; i++)
+	{
+		if (!converged[i - start])
 		{
-			std::vector<double> group_values;
-			kinematic_state->copyJointGroupPositions(joint_model_group,
-					group_values);
-			double* state_pos = kinematic_state->getVariablePositions();
-			for (std::size_t k = 0; k < kinematic_state->getVariableCount();
-					++k)
-			{
-				ik_solution[k] = state_pos[k];
-				(*getGroupTrajectory())(i, k) = state_pos[k];
-				(*getFullTrajectory())(full_traj_index, k) = state_pos[k];
-			}
+			ROS_INFO("Could not find IK solution for waypoint %d", i);
+			continue;
 		}
-		else
+		int full_traj_index = getGroupTrajectory()->getFullTrajectoryIndex(i);
+		for (int k = 0; k < num_joints_; k++)
 		{
-			ROS_INFO("Could not find IK solution for waypoint %d", i);
+			int kdl_joint = group_joint_to_kdl_joint_index_[k];
+			(*getGroupTrajectory())(i, k) = ik_solutions(i - start, kdl_joint);
+			(*getFullTrajectory())(full_traj_index, kdl_joint) = ik_solutions(i - start, kdl_joint);
 		}
 	}
+	if (num_converged != num_vars_free)
+		ROS_INFO("IK converged at %d of %d waypoints", num_converged, num_vars_free);
 	performForwardKinematics();
 
 	// check
@@ -716,69 +950,122 @@ bool EvaluationManager::performForwardKinematics(int begin, int end)
 	int safe_begin = max(0, begin);
 	int safe_end = min(num_points_, end);
 
+	UndoJournal& journal = data_->journal_;
+	journal.record(data_->segment_frames_[safe_begin], (safe_end - safe_begin) * data_->segment_frames_.cols());
+	journal.record(data_->joint_pos_[safe_begin], (safe_end - safe_begin) * data_->joint_pos_.cols());
+	journal.record(data_->joint_axis_[safe_begin], (safe_end - safe_begin) * data_->joint_axis_.cols());
+	journal.record(data_->fk_joint_values_[safe_begin], (safe_end - safe_begin) * data_->fk_joint_values_.cols());
+	journal.record(&data_->state_is_in_collision_[safe_begin], safe_end - safe_begin);
+	if (safe_end < num_points_)
+	{
+		journal.record(data_->segment_frames_[num_points_ - 1], data_->segment_frames_.cols());
+		journal.record(data_->joint_pos_[num_points_ - 1], data_->joint_pos_.cols());
+		journal.record(data_->joint_axis_[num_points_ - 1], data_->joint_axis_.cols());
+		journal.record(data_->fk_joint_values_[num_points_ - 1], data_->fk_joint_values_.cols());
+	}
+
 	// used in computeBaseFrames
 	int full_traj_index = getGroupTrajectory()->getFullTrajectoryIndex(
                               num_points_ - 1);
+	EvaluationData::ThreadScratch& scratch = data_->thread_scratch_[0];
 	getFullTrajectory()->getTrajectoryPointKDL(full_traj_index,
-			data_->kdl_joint_array_);
-	data_->fk_solver_.JntToCartFull(data_->kdl_joint_array_,
-                                    data_->joint_pos_[num_points_ - 1],
-                                    data_->joint_axis_[num_points_ - 1],
-                                    data_->segment_frames_[num_points_ - 1]);
+			scratch.kdl_joint_array_);
+	scratch.fk_solver_.JntToCartPartial(scratch.kdl_joint_array_,
+                                       data_->fk_joint_values_[num_points_ - 1],
+                                       data_->joint_pos_[num_points_ - 1],
+                                       data_->joint_axis_[num_points_ - 1],
+                                       data_->segment_frames_[num_points_ - 1]);
+	setFKJointValues(num_points_ - 1, scratch.kdl_joint_array_);
+
+	const int batch_size = single_precision_ ? KDL::TreeFkSolverJointPosAxisBatch::FLOAT_BATCH_SIZE
+			: KDL::TreeFkSolverJointPosAxisBatch::BATCH_SIZE;
+	if ((single_precision_ || PlanningParameters::getInstance()->getUseBatchForwardKinematics())
+			&& scratch.batch_fk_solver_.isSupported() && safe_end - safe_begin >= batch_size)
+	{
+		// several waypoints per call, one in each vector lane
+		int num_batches = (safe_end - safe_begin + batch_size - 1) / batch_size;
+        #pragma omp parallel for
+		for (int b = 0; b < num_batches; ++b)
+		{
+			EvaluationData::ThreadScratch& scratch = data_->thread_scratch_[omp_get_thread_num()];
+			int batch_begin = safe_begin + b * batch_size;
+			int num_batch_points = min(batch_size, safe_end - batch_begin);
+
+			KDL::Vector* joint_pos[KDL::TreeFkSolverJointPosAxisBatch::FLOAT_BATCH_SIZE];
+			KDL::Vector* joint_axis[KDL::TreeFkSolverJointPosAxisBatch::FLOAT_BATCH_SIZE];
+			KDL::Frame* segment_frames[KDL::TreeFkSolverJointPosAxisBatch::FLOAT_BATCH_SIZE];
+			for (int l = 0; l < num_batch_points; ++l)
+			{
+				int i = batch_begin + l;
+				getFullTrajectory()->getTrajectoryPointKDL(getGroupTrajectory()->getFullTrajectoryIndex(i),
+						scratch.batch_joint_arrays_[l]);
+				joint_pos[l] = data_->joint_pos_[i];
+				joint_axis[l] = data_->joint_axis_[i];
+				segment_frames[l] = data_->segment_frames_[i];
+			}
+			if (single_precision_)
+				scratch.batch_fk_solver_.JntToCartFullFloat(&scratch.batch_joint_arrays_[0], num_batch_points,
+						joint_pos, joint_axis, segment_frames);
+			else
+				scratch.batch_fk_solver_.JntToCartFull(&scratch.batch_joint_arrays_[0], num_batch_points,
+						joint_pos, joint_axis, segment_frames);
+
+			for (int l = 0; l < num_batch_points; ++l)
+			{
+				// float frames must not be reused by a later double precision JntToCartPartial
+				if (single_precision_)
+					invalidateFKJointValues(batch_begin + l);
+				else
+					setFKJointValues(batch_begin + l, scratch.batch_joint_arrays_[l]);
+				data_->state_is_in_collision_[batch_begin + l] = false;
+			}
+		}
+		return is_collision_free_;
+	}
 
 	// for each point in the trajectory
+    #pragma omp parallel for
 	for (int i = safe_begin; i < safe_end; ++i)
 	{
+        EvaluationData::ThreadScratch& scratch = data_->thread_scratch_[omp_get_thread_num()];
 		int full_traj_index = getGroupTrajectory()->getFullTrajectoryIndex(i);
 		getFullTrajectory()->getTrajectoryPointKDL(full_traj_index,
-				data_->kdl_joint_array_);
-		// TODO: ?
-		/*
-		 // update kdl_joint_array with vel, acc
-		 if (i < 1)
-		 {
-		 for (int j = 0; j < planning_group_->num_joints_; j++)
-		 {
-		 int target_joint = planning_group_->group_joints_[j].kdl_joint_index_;
-		 data_->kdl_joint_array_(target_joint) = (*getGroupTrajectory())(i, j);
-		 }
-		 }
-		 */
+				scratch.kdl_joint_array_);
 
 		//computeBaseFrames(data_->kdl_joint_array_, i);
-		if (i == safe_begin)
-			data_->fk_solver_.JntToCartFull(data_->kdl_joint_array_,
-                                            data_->joint_pos_[i], data_->joint_axis_[i],
-                                            data_->segment_frames_[i]);
-		else
-			data_->fk_solver_.JntToCartFull(data_->kdl_joint_array_,
-                                            data_->joint_pos_[i], data_->joint_axis_[i],
-                                            data_->segment_frames_[i]);
-		// TODO: check patrial FK
-		/*
-		 data_->fk_solver_.JntToCartPartial(data_->kdl_joint_array_,
-		 data_->joint_pos_[i], data_->joint_axis_[i],
-		 data_->segment_frames_[i]);
-		 */
+		// only the segments below the changed joints are recomputed
+		scratch.fk_solver_.JntToCartPartial(scratch.kdl_joint_array_, data_->fk_joint_values_[i],
+                                           data_->joint_pos_[i], data_->joint_axis_[i],
+                                           data_->segment_frames_[i]);
+		setFKJointValues(i, scratch.kdl_joint_array_);
 
 		data_->state_is_in_collision_[i] = false;
-
-		if (data_->state_is_in_collision_[i])
-		{
-			is_collision_free_ = false;
-		}
 	}
 
 	return is_collision_free_;
 }
 
+void EvaluationManager::setFKJointValues(int point, const KDL::JntArray& joint_array)
+{
+	double* values = data_->fk_joint_values_[point];
+	for (int j = 0; j < data_->fk_joint_values_.cols(); ++j)
+		values[j] = joint_array(j);
+}
+
+void EvaluationManager::invalidateFKJointValues(int point)
+{
+	double* values = data_->fk_joint_values_[point];
+	for (int j = 0; j < data_->fk_joint_values_.cols(); ++j)
+		values[j] = std::numeric_limits<double>::quiet_NaN();
+}
+
 void EvaluationManager::computeTrajectoryValidity()
 {
 	trajectory_validity_ = true;
 	const double clearance = 0.001;
 	int collisionBV = 8001;
-	visualization_msgs::Marker marker;
-	visualization_msgs::Marker markerTemp;
+
+	data_->journal_.record(&data_->state_validity_[1], num_points_ - 2);
 
 	for (int i = 1; i < num_points_ - 1; i++)
 	{
@@ -827,40 +1114,59 @@ void EvaluationManager::computeTrajectoryValidity()
 
 }
 
-void EvaluationManager::updateCoM(int point)
+// not called by the evaluation, TrajectoryCoMCost is disabled and does not read the CoM
+void EvaluationManager::computeCoM(int begin, int end)
 {
-	const KDL::SegmentMap& segmentMap =
-        robot_model_->getKDLTree()->getSegments();
-	// compute CoM, p_j
-	int mass_segment_index = 0;
-	data_->CoMPositions_[point] = KDL::Vector::Zero();
-	for (KDL::SegmentMap::const_iterator it = segmentMap.begin();
-			it != segmentMap.end(); ++it)
-	{
-		const KDL::Segment& segment = it->second.segment;
-		double mass = segment.getInertia().getMass();
-		if (mass == 0.0)
-			continue;
-		mass = masses_[mass_segment_index];
+	int safe_begin = max(0, begin);
+	int safe_end = min(num_points_, end);
 
-		int sn = robot_model_->getForwardKinematicsSolver()->segmentNameToIndex(
-                     segment.getName());
-		const KDL::Vector& pos = data_->segment_frames_[point][sn]
-                                 * segment.getInertia().getCOG();
+	// velocities and accelerations change within the stencil of the changed positions
+	const int halo = DIFF_RULE_LENGTH / 2;
+	int derivative_begin = max(halo, safe_begin - halo);
+	int derivative_end = min(num_points_ - halo, safe_end + halo);
 
-		data_->CoMPositions_[point] += pos * mass;
-		data_->linkPositions_[mass_segment_index][point] = pos;
+	UndoJournal& journal = data_->journal_;
+	journal.record(&data_->CoMPositions_[safe_begin], safe_end - safe_begin);
+	for (int m = 0; m < num_mass_segments_; ++m)
+		journal.record(&data_->linkPositions_[m][safe_begin], safe_end - safe_begin);
+	if (derivative_begin < derivative_end)
+	{
+		journal.record(&data_->CoMVelocities_[derivative_begin], derivative_end - derivative_begin);
+		journal.record(&data_->CoMAccelerations_[derivative_begin], derivative_end - derivative_begin);
+	}
 
-		++mass_segment_index;
+	// compute CoM, p_j
+    #pragma omp parallel for
+	for (int point = safe_begin; point < safe_end; ++point)
+	{
+		const KDL::Frame* segment_frames = data_->segment_frames_[point];
+		KDL::Vector com = KDL::Vector::Zero();
+		for (int m = 0; m < num_mass_segments_; ++m)
+		{
+			const MassSegment& mass_segment = mass_segments_[m];
+			KDL::Vector pos = segment_frames[mass_segment.segment_index_] * mass_segment.cog_;
+			data_->linkPositions_[m][point] = pos;
+			com += pos * mass_segment.mass_;
+		}
+		data_->CoMPositions_[point] = com / total_mass_;
+	}
+
+	if (derivative_begin < derivative_end)
+	{
+		getVectorVelocitiesAndAccelerations(derivative_begin, derivative_end - 1,
+				getGroupTrajectory()->getDiscretization(), data_->CoMPositions_,
+				data_->CoMVelocities_, data_->CoMAccelerations_, KDL::Vector::Zero());
 	}
-	data_->CoMPositions_[point] = data_->CoMPositions_[point] / total_mass_;
 
 	if (STABILITY_COST_VERBOSE)
 	{
-		printf("[%d] CoM Pos : (%f %f %f)\n", point,
-               data_->CoMPositions_[point].x(),
-               data_->CoMPositions_[point].y(),
-               data_->CoMPositions_[point].z());
+		for (int point = safe_begin; point < safe_end; ++point)
+		{
+			printf("[%d] CoM Pos : (%f %f %f)\n", point,
+	               data_->CoMPositions_[point].x(),
+	               data_->CoMPositions_[point].y(),
+	               data_->CoMPositions_[point].z());
+		}
 	}
 }
 
@@ -869,42 +1175,61 @@ void EvaluationManager::computeCollisionCosts(int begin, int end)
     if (PlanningParameters::getInstance()->getObstacleCostWeight() == 0.0)
         return;
 
-	int num_all_joints = data_->kinematic_state_[0]->getVariableCount();
+	if (PlanningParameters::getInstance()->getUseSDFCollisionCost())
+	{
+		computeSDFCollisionCosts(begin, end);
+		return;
+	}
 
-    int num_threads = getNumParallelThreads();
+	int num_all_joints = data_->kinematic_state_[0]->getVariableCount();
 
 	collision_detection::CollisionRequest collision_request;
 	collision_request.verbose = false;
 	collision_request.contacts = true;
 	collision_request.max_contacts = 1000;
 
-    std::vector<collision_detection::CollisionResult> collision_result(num_threads);
-	std::vector<std::vector<double> > positions(num_threads);
-
-	for (int i = 0; i < num_threads; ++i)
-	{
-		positions[i].resize(num_all_joints);
-	}
-
 	int safe_begin = max(0, begin);
 	int safe_end = min(num_points_, end);
+
+	data_->journal_.record(&data_->stateCollisionCost_[safe_begin], safe_end - safe_begin);
+	data_->journal_.record(&data_->state_is_in_collision_[safe_begin], safe_end - safe_begin);
+
     #pragma omp parallel for
 	for (int i = safe_begin; i < safe_end; ++i)
 	{
         int thread_num = omp_get_thread_num();
+        std::vector<double>& positions = data_->thread_scratch_[thread_num].positions_;
+        collision_detection::CollisionResult& collision_result = data_->thread_scratch_[thread_num].collision_result_;
 
 		double depthSum = 0.0;
 
 		int full_traj_index = getGroupTrajectory()->getFullTrajectoryIndex(i);
 		for (std::size_t k = 0; k < num_all_joints; k++)
 		{
-            positions[thread_num][k] = (*getFullTrajectory())(full_traj_index, k);
+            positions[k] = (*getFullTrajectory())(full_traj_index, k);
+		}
+
+		boost::uint64_t cache_key = 0;
+		boost::uint32_t cache_check = 0;
+		if (collision_cache_)
+		{
+			bool in_collision;
+			collision_cache_->computeKey(&positions[0], num_all_joints, cache_key, cache_check);
+			if (collision_cache_->lookup(cache_key, cache_check, depthSum, in_collision))
+			{
+				if (in_collision)
+					last_trajectory_collision_free_ = false;
+				data_->state_is_in_collision_[i] = in_collision;
+				data_->stateCollisionCost_[i] = depthSum;
+				continue;
+			}
 		}
-        data_->kinematic_state_[thread_num]->setVariablePositions(&positions[thread_num][0]);
-        data_->planning_scene_->checkCollisionUnpadded(collision_request, collision_result[thread_num],
+
+        data_->kinematic_state_[thread_num]->setVariablePositions(&positions[0]);
+        data_->planning_scene_->checkCollisionUnpadded(collision_request, collision_result,
 				*data_->kinematic_state_[thread_num]);
 
-        const collision_detection::CollisionResult::ContactMap& contact_map = collision_result[thread_num].contacts;
+        const collision_detection::CollisionResult::ContactMap& contact_map = collision_result.contacts;
         for (collision_detection::CollisionResult::ContactMap::const_iterator it = contact_map.begin(); it != contact_map.end(); ++it)
 		{
 			const collision_detection::Contact& contact = it->second[0];
@@ -913,91 +1238,174 @@ void EvaluationManager::computeCollisionCosts(int begin, int end)
 
 			last_trajectory_collision_free_ = false;
 		}
-		collision_result[thread_num].clear();
+		data_->state_is_in_collision_[i] = !contact_map.empty();
+		collision_result.clear();
 		data_->stateCollisionCost_[i] = depthSum;
+		if (collision_cache_)
+			collision_cache_->insert(cache_key, cache_check, depthSum, data_->state_is_in_collision_[i]);
 	}
 }
 
-std::vector<double> computeFTR(const std::string& group_name,
-                               int contact_point_index, int begin, int end, const EvaluationData* data,
-                               const ItompPlanningGroup * planning_group)
+// CHOMP obstacle cost of the collision spheres, using the segment frames of the forward kinematics
+void EvaluationManager::computeSDFCollisionCosts(int begin, int end)
 {
-	std::vector<double> positions, trajectory_ftrs;
-	int num_joints = data->getFullTrajectory()->getNumJoints();
-	positions.resize(num_joints);
-	for (int i = begin; i < end; ++i)
+	const SignedDistanceField* sdf = SignedDistanceField::getInstance();
+	ROS_ASSERT(sdf->isInitialized());
+	const std::vector<SignedDistanceField::CollisionSphere>& spheres = sdf->getCollisionSpheres();
+	double clearance = PlanningParameters::getInstance()->getSDFClearance();
+
+	int safe_begin = max(0, begin);
+	int safe_end = min(num_points_, end);
+
+	data_->journal_.record(&data_->stateCollisionCost_[safe_begin], safe_end - safe_begin);
+	data_->journal_.record(&data_->state_is_in_collision_[safe_begin], safe_end - safe_begin);
+
+	// the points only write their own entries, the spheres and the field are read-only
+	#pragma omp parallel for
+	for (int i = safe_begin; i < safe_end; ++i)
 	{
-		int full_traj_index =
-            data->getGroupTrajectory()->getFullTrajectoryIndex(i);
-		double cost = 0;
-		for (std::size_t k = 0; k < num_joints; k++)
+		const KDL::Frame* frames = data_->segment_frames_[i];
+		double cost = 0.0;
+		bool in_collision = false;
+		for (std::size_t s = 0; s < spheres.size(); ++s)
+		{
+			const SignedDistanceField::CollisionSphere& sphere = spheres[s];
+			double distance = sdf->getDistance(frames[sphere.segment_index_] * sphere.center_) - sphere.radius_;
+			if (distance < 0.0)
+			{
+				cost += 0.5 * clearance - distance;
+				in_collision = true;
+			}
+			else if (distance < clearance)
+			{
+				double d = distance - clearance;
+				cost += 0.5 * d * d / clearance;
+			}
+		}
+		if (in_collision)
+			last_trajectory_collision_free_ = false;
+		data_->state_is_in_collision_[i] = in_collision;
+		data_->stateCollisionCost_[i] = cost;
+	}
+}
+
+// FCL check of the points of the full trajectory, without contacts
+bool EvaluationManager::isTrajectoryCollisionFreeExact()
+{
+	int num_all_joints = data_->kinematic_state_[0]->getVariableCount();
+	std::vector<double>& positions = data_->thread_scratch_[0].positions_;
+	collision_detection::CollisionResult& collision_result = data_->thread_scratch_[0].collision_result_;
+
+	collision_detection::CollisionRequest collision_request;
+	collision_request.verbose = false;
+	collision_request.contacts = false;
+
+	for (int i = full_vars_start_ + 1; i < full_vars_end_ - 1; ++i)
+	{
+		int full_traj_index = getGroupTrajectory()->getFullTrajectoryIndex(i);
+		for (int k = 0; k < num_all_joints; k++)
+		{
+			positions[k] = (*getFullTrajectory())(full_traj_index, k);
+		}
+		data_->kinematic_state_[0]->setVariablePositions(&positions[0]);
+		collision_result.clear();
+		data_->planning_scene_->checkCollisionUnpadded(collision_request, collision_result,
+				*data_->kinematic_state_[0]);
+		if (collision_result.collision)
 		{
-			positions[k] = (*data->getFullTrajectory())(full_traj_index, k);
+			collision_result.clear();
+			return false;
 		}
-		data->kinematic_state_[0]->setVariablePositions(&positions[0]);
-		robot_model::RobotModelConstPtr robot_model_ptr =
-            data->getItompRobotModel()->getRobotModel();
-		Eigen::MatrixXd jacobianFull = (data->kinematic_state_[0]->getJacobian(
-                                            robot_model_ptr->getJointModelGroup(group_name)));
-		Eigen::MatrixXd jacobian = jacobianFull.block(0, 0, 3,
-                                   jacobianFull.cols());
-		Eigen::MatrixXd jacobian_transpose = jacobian.transpose();
+	}
+	collision_result.clear();
+	return true;
+}
+
+bool EvaluationManager::isLastTrajectoryFeasible() const
+{
+	return last_trajectory_collision_free_;
+}
+
+bool EvaluationManager::checkLastTrajectoryFeasibility()
+{
+	// the approximate results can only miss collisions, infeasible trajectories need no exact check
+	if (exact_collision_check_pending_)
+	{
+		exact_collision_check_pending_ = false;
+		if (last_trajectory_collision_free_)
+			last_trajectory_collision_free_ = isTrajectoryCollisionFreeExact();
+	}
+	return last_trajectory_collision_free_;
+}
+
+// writes the costs of the points in [begin, end) to data->contact_ftr_costs_[contact_point_index]
+void computeFTR(int contact_point_index, int begin, int end, EvaluationData* data,
+                const ItompPlanningGroup * planning_group)
+{
+	const ChainJacobian& jacobian = planning_group->contact_jacobians_[contact_point_index];
+	const ContactPoint& contact_point = planning_group->contactPoints_[contact_point_index];
+	#pragma omp parallel for
+	for (int i = begin; i < end; ++i)
+	{
+		double cost = 0;
 
 		// computing direction, first version as COM velocity between poses
 		const KDL::Vector& dir_kdl =
             data->contact_forces_[i][contact_point_index];
-		Eigen::Vector3d direction(dir_kdl.x(), dir_kdl.y(), dir_kdl.z());
-		if (direction.norm() != 0)
+		double dir_norm = dir_kdl.Norm();
+		if (dir_norm != 0)
 		{
-			direction.normalize();
-			double ftr = 1
-                         / std::sqrt(
-                             direction.transpose()
-                             * (jacobian * jacobian_transpose)
-                             * direction);
+			KDL::Vector direction = dir_kdl / dir_norm;
+			double jjt = jacobian.computeDirectionalManipulability(data->joint_pos_[i],
+					data->joint_axis_[i], data->segment_frames_[i], direction);
+			double ftr = 1 / std::sqrt(jjt);
 			KDL::Vector position, unused, normal;
-			planning_group->contactPoints_[contact_point_index].getPosition(i,
-					position, data->segment_frames_);
+			contact_point.getPosition(i, position, data->segment_frames_);
 			GroundManager::getInstance().getNearestGroundPosition(position,
 					unused, normal, data->planning_scene_); // TODO get more accurate normal
-			Eigen::Vector3d normalEigen(normal.x(), normal.y(), normal.z());
-			double contact_variable =
-                data->getGroupTrajectory()->getContactTrajectory()(
-                    i
-                    / data->getGroupTrajectory()->getContactPhaseStride(),
-                    contact_point_index);
-
-			ftr *= -direction.dot(normalEigen);
+
+			ftr *= -KDL::dot(direction, normal);
 			// bound value btw -10 and 10, then 0 and 1
 			ftr = (ftr < -10) ? -10 : ftr;
 			ftr = (ftr > 10) ? 10 : ftr;
 			ftr = (ftr + 10) / 20;
-			cost = dir_kdl.Norm() - ftr;
+			cost = dir_norm - ftr;
 			cost = (cost < 0) ? 0 : cost;
 		}
-		trajectory_ftrs.push_back(cost);
+		data->contact_ftr_costs_[contact_point_index][i] = cost;
 	}
-	return trajectory_ftrs;
 }
 
 void EvaluationManager::computeFTRs(int begin, int end)
 {
+	if (PlanningParameters::getInstance()->getFTRCostWeight() == 0.0)
+		return;
+
+	// feet first, then hands
+	const int num_contacts = planning_group_->getNumContacts();
+	if (num_contacts != 4)
+		return;
+	for (int i = 0; i < num_contacts; ++i)
+	{
+		if (!planning_group_->contact_jacobians_[i].isValid())
+			return;
+	}
+
 	int safe_begin = max(0, begin);
 	int safe_end = min(num_points_, end);
-	std::vector<double> left_leg_cost = computeFTR("left_leg", 0, safe_begin,
-                                        safe_end, data_, planning_group_);
-	std::vector<double> right_leg_cost = computeFTR("right_leg", 1, safe_begin,
-                                         safe_end, data_, planning_group_);
-	std::vector<double> left_arm_cost = computeFTR("left_arm", 2, safe_begin,
-                                        safe_end, data_, planning_group_);
-	std::vector<double> right_arm_cost = computeFTR("right_arm", 3, safe_begin,
-                                         safe_end, data_, planning_group_);
+
+	data_->journal_.record(&data_->stateFTRCost_[safe_begin], safe_end - safe_begin);
+	for (int i = 0; i < data_->contact_ftr_costs_.rows(); ++i)
+		data_->journal_.record(&data_->contact_ftr_costs_[i][safe_begin], safe_end - safe_begin);
+
+	for (int i = 0; i < num_contacts; ++i)
+		computeFTR(i, safe_begin, safe_end, data_, planning_group_);
+	const ContiguousArray2D<double>& ftr_costs = data_->contact_ftr_costs_;
 	for (unsigned int i = safe_begin; i < safe_end; ++i)
 	{
-		int v_index = i - safe_begin;
-		data_->stateFTRCost_[i] = (left_leg_cost[v_index]
-                                   + right_leg_cost[v_index])
-                                  + 0.5 * (left_arm_cost[v_index] + right_arm_cost[v_index]);
+		data_->stateFTRCost_[i] = (ftr_costs[0][i]
+                                   + ftr_costs[1][i])
+                                  + 0.5 * (ftr_costs[2][i] + ftr_costs[3][i]);
 	}
 
 }
@@ -1012,9 +1420,9 @@ void EvaluationManager::printDebugInfo()
 	{
 		// position constraint
 
-		const int END_EFFECTOR_SEGMENT_INDEX =
-            robot_model_->getForwardKinematicsSolver()->segmentNameToIndex(
-                "tcp_2_link");
+		const int END_EFFECTOR_SEGMENT_INDEX = cartesian_tool_segment_;
+		if (END_EFFECTOR_SEGMENT_INDEX == -1)
+			return;
 
 		data_->costAccumulator_.is_last_trajectory_valid_ = true;
 
@@ -1069,7 +1477,7 @@ void EvaluationManager::computeCartesianTrajectoryCosts()
 	{
 		// position constraint
 
-        const int END_EFFECTOR_SEGMENT_INDEX = robot_model_->getForwardKinematicsSolver()->segmentNameToIndex("tcp_2_link");
+		const int END_EFFECTOR_SEGMENT_INDEX = cartesian_tool_segment_;
 
 		const double rotation_weight = 0.0;
 
@@ -1078,7 +1486,7 @@ void EvaluationManager::computeCartesianTrajectoryCosts()
 		for (int i = 0; i < num_points_; ++i)
 			data_->stateCartesianTrajectoryCost_[i] = 0;
 
-		if (data_->cartesian_waypoints_.size() == 0)
+		if (data_->cartesian_waypoints_.size() == 0 || END_EFFECTOR_SEGMENT_INDEX == -1)
 			return;
 
 		KDL::Vector start_pos = data_->cartesian_waypoints_[0].p;
@@ -1132,9 +1540,9 @@ void EvaluationManager::computeCartesianTrajectoryCosts()
 		// orientation constraint
 
 		// TODO: fix hard-coded values
-		const int END_EFFECTOR_SEGMENT_INDEX =
-            robot_model_->getForwardKinematicsSolver()->segmentNameToIndex(
-                "segment_7");
+		const int END_EFFECTOR_SEGMENT_INDEX = cartesian_flange_segment_;
+		if (END_EFFECTOR_SEGMENT_INDEX == -1)
+			return;
 
 		data_->costAccumulator_.is_last_trajectory_valid_ = true;
 
@@ -1202,70 +1610,33 @@ void computeFrameDebug(int point, const char* label, const char* v1_name,
 
 void EvaluationManager::computeSingularityCosts(int begin, int end)
 {
-	const string group_name = planning_group_->name_;
-
 	if (PlanningParameters::getInstance()->getSingularityCostWeight() == 0.0)
 		return;
 
-	return;
+	const ChainJacobian& chain_jacobian = planning_group_->jacobian_;
+	if (!chain_jacobian.isValid())
+		return;
 
-	double min_singular_value = std::numeric_limits<double>::max();
-	int min_singular_value_index = begin;
+	int safe_begin = max(full_vars_start_ + 1, begin);
+	int safe_end = min(full_vars_end_ - 1, end);
+	data_->journal_.record(&data_->stateSingularityCost_[safe_begin], safe_end - safe_begin);
 
-	std::vector<double> positions;
-	int num_joints = data_->getFullTrajectory()->getNumJoints();
-	positions.resize(num_joints);
-	for (int i = begin; i < end; ++i)
+	// (1 - w / threshold)^2 below the manipulability threshold, 0 above
+	const double threshold = PlanningParameters::getInstance()->getSingularityManipulabilityThreshold();
+	#pragma omp parallel for
+	for (int i = safe_begin; i < safe_end; ++i)
 	{
-		data_->stateSingularityCost_[i] = 0.0;
-
-		int full_traj_index =
-            data_->getGroupTrajectory()->getFullTrajectoryIndex(i);
-		double cost = 0;
-		for (std::size_t k = 0; k < num_joints; k++)
-		{
-			positions[k] = (*data_->getFullTrajectory())(full_traj_index, k);
-		}
-		int sz = data_->kinematic_state_[0]->getVariableCount();
-		data_->kinematic_state_[0]->setVariablePositions(&positions[0]);
-		data_->kinematic_state_[0]->update();
-		robot_model::RobotModelConstPtr robot_model_ptr =
-            data_->getItompRobotModel()->getRobotModel();
-
-		const moveit::core::JointModelGroup* jmg =
-            robot_model_ptr->getJointModelGroup(group_name);
-		Eigen::MatrixXd jacobianFull = (data_->kinematic_state_[0]->getJacobian(
-                                            jmg));
-
-		int rows2 = jacobianFull.rows();
-		cout << jacobianFull << endl;
-		for (int k = 0; k < num_joints; ++k)
-			printf("%f ", positions[k]);
-		printf("\n");
-
-		Eigen::JacobiSVD<Eigen::MatrixXd> svd(jacobianFull);
-		cout << svd.singularValues() << endl;
-
-		/*
-		 printf("[%d] svd values : ", i);
-		 for (int j = 0; j < svd.singularValues().rows(); ++j)
-		 {
-		 printf("%f ", svd.singularValues()(j));
-		 }
-		 printf("\n");
-		 */
-
-		int rows = svd.singularValues().rows();
-		double value = (rows == 0 ? 0.0 : svd.singularValues()(rows - 1));
-		if (value < min_singular_value)
+		Eigen::MatrixXd& jacobian = data_->thread_scratch_[omp_get_thread_num()].jacobian_;
+		double manipulability = chain_jacobian.computeManipulability(data_->joint_pos_[i],
+				data_->joint_axis_[i], data_->segment_frames_[i], jacobian);
+		double cost = 0.0;
+		if (manipulability < threshold)
 		{
-			min_singular_value = value;
-			min_singular_value_index = i;
+			cost = 1.0 - manipulability / threshold;
+			cost *= cost;
 		}
+		data_->stateSingularityCost_[i] = cost;
 	}
-	if (print_debug_texts_)
-		printf("Min Singular value : (%d) %f ", min_singular_value_index,
-               min_singular_value);
 }
 
 }
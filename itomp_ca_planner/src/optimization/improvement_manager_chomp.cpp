@@ -38,8 +38,8 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <itomp_ca_planner/optimization/improvement_manager_chomp.h>
 #include <itomp_ca_planner/util/planning_parameters.h>
 #include <itomp_ca_planner/util/differentiation_rules.h>
+#include <itomp_ca_planner/util/fast_exp.h>
 #include <itomp_ca_planner/model/itomp_robot_joint.h>
-#include <Eigen/LU>
 #include <iostream>
 
 using namespace Eigen;
@@ -74,6 +74,11 @@ bool ImprovementManagerChomp::updatePlanningParameters()
 
     use_cumulative_costs_ = PlanningParameters::getInstance()->getUseCumulativeCosts();
     use_smooth_noises_ = PlanningParameters::getInstance()->getUseSmoothNoises();
+    use_parallel_rollout_evaluation_ = PlanningParameters::getInstance()->getUseParallelRolloutEvaluation();
+    use_float_rollout_evaluation_ = PlanningParameters::getInstance()->getUseFloatRolloutEvaluation();
+    num_ranking_checks_ = 0;
+    num_ranking_changes_ = 0;
+    num_best_rollout_changes_ = 0;
 
     const std::vector<ItompRobotJoint>& group_joints = evaluation_manager_->getPlanningGroup()->group_joints_;
     for (int i = 0; i < group_joints.size(); ++i)
@@ -92,19 +97,20 @@ bool ImprovementManagerChomp::updatePlanningParameters()
     free_vars_start_index_ = DIFF_RULE_LENGTH - 1;
     free_vars_end_index_ = free_vars_start_index_ + num_vars_free_ - 1;
     parameters_all_.resize(num_dimensions_, Eigen::VectorXd::Zero(num_vars_all_));
-    parameters_.resize(num_dimensions_, Eigen::VectorXd::Zero(num_time_steps_));
+    parameters_ = Eigen::MatrixXd::Zero(num_time_steps_, num_dimensions_);
     num_contact_vars_free_ = num_contact_time_steps_;
     num_contact_vars_all_ = num_contact_vars_free_ + 2;
     free_contact_vars_start_index_ = 1;
     free_contact_vars_end_index_ = free_contact_vars_start_index_ + num_contact_vars_free_ - 1;
     contact_parameters_all_.resize(num_contact_dimensions_, Eigen::VectorXd::Zero(num_contact_vars_all_));
-    contact_parameters_.resize(num_contact_dimensions_, Eigen::VectorXd::Zero(num_contact_time_steps_));
+    contact_parameters_ = Eigen::MatrixXd::Zero(num_contact_time_steps_, num_contact_dimensions_);
 
     copyGroupTrajectory();
 
     initializeCosts();
     initializeNoiseGenerators();
     initializeRollouts();
+    initializeRolloutEvaluationManagers();
 
     preAllocateTempVariables();
 
@@ -123,47 +129,12 @@ void ImprovementManagerChomp::initializeRollouts()
         return;
     }
 
-    // preallocate memory for a single rollout:
-    Rollout rollout;
-
-    rollout.parameters_.clear();
-    rollout.noise_.clear();
-    rollout.noise_projected_.clear();
-    rollout.parameters_noise_projected_.clear();
-    rollout.control_costs_.clear();
-    rollout.total_costs_.clear();
-    rollout.cumulative_costs_.clear();
-    rollout.probabilities_.clear();
-    for (int d = 0; d < num_dimensions_; ++d)
-    {
-        rollout.parameters_.push_back(VectorXd::Zero(num_time_steps_));
-        rollout.noise_.push_back(VectorXd::Zero(num_time_steps_));
-        rollout.noise_projected_.push_back(VectorXd::Zero(num_time_steps_));
-        rollout.control_costs_.push_back(VectorXd::Zero(num_time_steps_));
-        rollout.total_costs_.push_back(VectorXd::Zero(num_time_steps_));
-        rollout.cumulative_costs_.push_back(VectorXd::Zero(num_time_steps_));
-        rollout.probabilities_.push_back(VectorXd::Zero(num_time_steps_));
-    }
-    rollout.state_costs_ = VectorXd::Zero(num_time_steps_);
-
-    rollout.contact_parameters_.clear();
-    rollout.contact_noise_.clear();
-    for (int d = 0; d < num_contact_dimensions_; ++d)
-    {
-        rollout.contact_parameters_.push_back(VectorXd::Zero(num_contact_time_steps_));
-        rollout.contact_noise_.push_back(VectorXd::Zero(num_contact_time_steps_));
-    }
-    rollout.contact_probabilities_ = VectorXd::Zero(num_contact_time_steps_);
-
-    // duplicate this rollout:
-    for (int r = 0; r < num_rollouts_; ++r)
-        rollouts_.push_back(rollout);
-
-    for (int r = 0; r < num_rollouts_reused_; ++r)
-        reused_rollouts_.push_back(rollout);
-
-    for (int r = 0; r < num_rollouts_extra_; ++r)
-        extra_rollouts_.push_back(rollout);
+    // one slot per rollout and per extra rollout. reused rollouts keep their slots
+    int num_slots = num_rollouts_ + num_rollouts_extra_;
+    rollouts_.resize(num_slots, num_dimensions_, num_time_steps_, num_contact_dimensions_, num_contact_time_steps_);
+    rollout_slots_.resize(num_slots);
+    for (int s = 0; s < num_slots; ++s)
+        rollout_slots_[s] = s;
 
     rollouts_reused_ = false;
     rollouts_reused_next_ = false;
@@ -174,118 +145,82 @@ void ImprovementManagerChomp::initializeRollouts()
     tmp_rollout_cost_ = Eigen::VectorXd::Zero(num_time_steps_);
 }
 
+void ImprovementManagerChomp::initializeRolloutEvaluationManagers()
+{
+    rollout_evaluation_managers_.clear();
+    tmp_rollout_costs_.clear();
+    if (!use_parallel_rollout_evaluation_)
+        return;
+
+    // each slot is evaluated by its own evaluation manager,
+    // which owns a copy of the evaluation data and the trajectories.
+    // reused rollouts keep their slots, so their managers only re-evaluate the changed points
+    for (int s = 0; s < rollouts_.getNumSlots(); ++s)
+        rollout_evaluation_managers_.push_back(EvaluationManagerPtr(evaluation_manager_->clone()));
+    for (int r = 0; r < num_rollouts_; ++r)
+        tmp_rollout_costs_.push_back(VectorXd::Zero(num_time_steps_));
+}
+
 void ImprovementManagerChomp::initializeCosts()
 {
     control_cost_weight_ = PlanningParameters::getInstance()->getSmoothnessCostWeight();
 
     double multiplier = 1.0;
-    differentiation_matrices_.clear();
-    differentiation_matrices_.resize(NUM_DIFF_RULES, MatrixXd::Zero(num_vars_all_, num_vars_all_));
     for (int d = 0; d < NUM_DIFF_RULES; ++d)
     {
         multiplier /= PlanningParameters::getInstance()->getTrajectoryDiscretization();
-        for (int i = 0; i < num_vars_all_; i++)
-        {
-            for (int j = -DIFF_RULE_LENGTH / 2; j <= DIFF_RULE_LENGTH / 2; j++)
-            {
-                int index = i + j;
-                if (index < 0)
-                    continue;
-                if (index >= num_vars_all_)
-                    continue;
-                differentiation_matrices_[d](i, index) = multiplier * DIFF_RULES[d][j + DIFF_RULE_LENGTH / 2];
-            }
-        }
-        //ROS_INFO_STREAM(differentiation_matrices_[d]);
-    }
-
-    control_costs_all_.clear();
-    control_costs_.clear();
-    inv_control_costs_.clear();
-    for (int d = 0; d < num_dimensions_; ++d)
-    {
-        // construct the quadratic cost matrices (for all variables)
-        MatrixXd cost_all = MatrixXd::Identity(num_vars_all_, num_vars_all_)
-                            * PlanningParameters::getInstance()->getRidgeFactor();
-        for (int i = 0; i < NUM_DIFF_RULES; ++i)
-        {
-            cost_all += PlanningParameters::getInstance()->getSmoothnessCosts()[i]
-                        * (differentiation_matrices_[i].transpose() * differentiation_matrices_[i]);
-        }
-        control_costs_all_.push_back(cost_all);
-
-        // extract the quadratic cost just for the free variables:
-        MatrixXd cost_free = cost_all.block(DIFF_RULE_LENGTH - 1, DIFF_RULE_LENGTH - 1, num_vars_free_, num_vars_free_);
-        control_costs_.push_back(cost_free);
-
-        inv_control_costs_.push_back(cost_free.fullPivLu().inverse());
+        for (int j = 0; j < DIFF_RULE_LENGTH; ++j)
+            differentiation_stencils_[d][j] = multiplier * DIFF_RULES[d][j];
     }
 
+    // the factored control cost and the projection scales are shared by every optimizer and request
     ROS_INFO("Precomputing projection matrices..");
-    projection_matrix_.resize(num_dimensions_);
-    for (int d = 0; d < num_dimensions_; ++d)
-    {
-        if (use_smooth_noises_)
-        {
-            projection_matrix_[d] = inv_control_costs_[d];
-            for (int p = 0; p < num_time_steps_; ++p)
-            {
-                double column_max = inv_control_costs_[d](0, p);
-                for (int p2 = 1; p2 < num_time_steps_; ++p2)
-                {
-                    if (inv_control_costs_[d](p2, p) > column_max)
-                        column_max = inv_control_costs_[d](p2, p);
-                }
-                projection_matrix_[d].col(p) *= (1.0 / (num_time_steps_ * column_max));
-            }
-        }
-        else
-        {
-            projection_matrix_[d].setIdentity(inv_control_costs_[d].rows(), inv_control_costs_[d].cols());
-        }
-    }
+    control_cost_ = SmoothnessCostCache::getInstance().getControlCost(num_vars_free_,
+            PlanningParameters::getInstance()->getTrajectoryDiscretization(),
+            PlanningParameters::getInstance()->getSmoothnessCosts(),
+            PlanningParameters::getInstance()->getRidgeFactor(), use_smooth_noises_);
     ROS_INFO("Done precomputing projection matrices.");
 }
 
+void ImprovementManagerChomp::projectUpdates(Eigen::Block<Eigen::MatrixXd> updates) const
+{
+    if (!use_smooth_noises_)
+        return;
+    updates = control_cost_->projection_scales_.asDiagonal() * updates;
+    control_cost_->cholesky_.solveInPlace(updates);
+}
+
 void ImprovementManagerChomp::initializeNoiseGenerators()
 {
-    // invert the control costs, initialize noise generators:
+    // the noise covariance is the inverse of the control costs, sampled from their banded factorization
+    noise_generators_.clear();
     for (int d = 0; d < num_dimensions_; ++d)
     {
-        MultivariateGaussian mvg(VectorXd::Zero(num_time_steps_), inv_control_costs_[d]);
-        noise_generators_.push_back(mvg);
+        noise_generators_.push_back(BandedGaussianSampler(control_cost_->cholesky_));
     }
+    BandedCholesky identity;
+    identity.compute(MatrixXd::Ones(1, num_contact_time_steps_));
     contact_noise_generators_.clear();
     for (int d = 0; d < num_contact_dimensions_; ++d)
     {
-        MultivariateGaussian mvg(VectorXd::Zero(num_contact_time_steps_),
-                                 MatrixXd::Identity(num_contact_time_steps_, num_contact_time_steps_));
-        contact_noise_generators_.push_back(mvg);
+        contact_noise_generators_.push_back(BandedGaussianSampler(identity));
     }
 }
 
 bool ImprovementManagerChomp::preAllocateTempVariables()
 {
-    tmp_noise_.clear();
-    tmp_contact_noise_.clear();
-    tmp_parameters_.clear();
-    parameter_updates_.clear();
-    contact_parameter_updates_.clear();
-    for (int d = 0; d < num_dimensions_; ++d)
-    {
-        tmp_noise_.push_back(VectorXd::Zero(num_time_steps_));
-        tmp_parameters_.push_back(VectorXd::Zero(num_time_steps_));
-        parameter_updates_.push_back(MatrixXd::Zero(num_time_steps_, num_time_steps_));
-        time_step_weights_.push_back(VectorXd::Zero(num_time_steps_));
-    }
-    for (int d = 0; d < num_contact_dimensions_; ++d)
-    {
-        tmp_contact_noise_.push_back(VectorXd::Zero(num_contact_time_steps_));
-        contact_parameter_updates_.push_back(VectorXd::Zero(num_contact_time_steps_));
-    }
-    tmp_max_cost_ = VectorXd::Zero(num_time_steps_);
-    tmp_min_cost_ = VectorXd::Zero(num_time_steps_);
-    tmp_sum_rollout_probabilities_ = VectorXd::Zero(num_time_steps_);
+    tmp_noise_ = MatrixXd::Zero(num_rollouts_, num_time_steps_);
+    tmp_contact_noise_ = MatrixXd::Zero(num_rollouts_, num_contact_time_steps_);
+    tmp_parameters_all_ = VectorXd::Zero(num_vars_all_);
+    tmp_rollout_slots_.resize(rollout_slots_.size());
+    tmp_rollout_reused_.resize(rollout_slots_.size());
+    parameter_updates_ = MatrixXd::Zero(num_time_steps_, num_dimensions_);
+    time_step_weights_ = MatrixXd::Zero(num_time_steps_, num_dimensions_);
+    contact_parameter_updates_ = MatrixXd::Zero(num_contact_time_steps_, num_contact_dimensions_);
+    tmp_max_cost_ = MatrixXd::Zero(num_time_steps_, num_dimensions_);
+    tmp_min_cost_ = MatrixXd::Zero(num_time_steps_, num_dimensions_);
+    tmp_inv_cost_range_ = MatrixXd::Zero(num_time_steps_, num_dimensions_);
+    tmp_sum_rollout_probabilities_ = MatrixXd::Zero(num_time_steps_, num_dimensions_);
 
     return true;
 }
@@ -312,14 +247,7 @@ void ImprovementManagerChomp::runSingleIteration(int iteration)
 
     // get rollouts and execute them
     generateRollouts(noise, contact_noise);
-
-    for (unsigned int r = 0; r < rollouts_.size(); ++r)
-    {
-        evaluation_manager_->setTrajectory(rollouts_[r].parameters_, rollouts_[r].contact_parameters_);
-        //evaluation_manager_->evaluate(rollouts_[r].parameters_, rollouts_[r].contact_parameters_, tmp_rollout_cost_);
-        evaluation_manager_->evaluate(tmp_rollout_cost_);
-        rollout_costs_.row(r) = tmp_rollout_cost_.transpose();
-    }
+    evaluateRollouts();
     /*
     Eigen::VectorXd costs(rollouts_.size());
     for (int i = 0; i < rollouts_.size(); ++i)
@@ -347,6 +275,81 @@ void ImprovementManagerChomp::runSingleIteration(int iteration)
     //evaluation_manager_->getFullTrajectoryConst()->printTrajectory();
 }
 
+void ImprovementManagerChomp::evaluateRollouts()
+{
+    evaluateRollouts(use_float_rollout_evaluation_);
+    if (!use_float_rollout_evaluation_ || !PlanningParameters::getInstance()->getFloatRolloutRankingCheck())
+        return;
+
+    // evaluate again in double and compare the rankings by the total cost
+    float_rollout_costs_ = rollout_costs_;
+    evaluateRollouts(false);
+
+    float_rollout_cost_sorter_.clear();
+    rollout_cost_sorter_.clear();
+    for (int r = 0; r < num_rollouts_; ++r)
+    {
+        float_rollout_cost_sorter_.push_back(std::make_pair(float_rollout_costs_.row(r).sum(), r));
+        rollout_cost_sorter_.push_back(std::make_pair(rollout_costs_.row(r).sum(), r));
+    }
+    std::sort(float_rollout_cost_sorter_.begin(), float_rollout_cost_sorter_.end());
+    std::sort(rollout_cost_sorter_.begin(), rollout_cost_sorter_.end());
+
+    ++num_ranking_checks_;
+    for (int r = 0; r < num_rollouts_; ++r)
+    {
+        if (float_rollout_cost_sorter_[r].second != rollout_cost_sorter_[r].second)
+        {
+            ++num_ranking_changes_;
+            break;
+        }
+    }
+    if (float_rollout_cost_sorter_[0].second != rollout_cost_sorter_[0].second)
+        ++num_best_rollout_changes_;
+}
+
+void ImprovementManagerChomp::evaluateRollouts(bool single_precision)
+{
+    if (!use_parallel_rollout_evaluation_)
+    {
+        evaluation_manager_->setSinglePrecision(single_precision);
+        for (int r = 0; r < num_rollouts_; ++r)
+        {
+            int slot = rollout_slots_[r];
+            evaluation_manager_->setTrajectory(rollouts_.getSlot(rollouts_.parameters_, slot),
+                                               rollouts_.getSlot(rollouts_.contact_parameters_, slot));
+            //evaluation_manager_->evaluate(rollouts_[r].parameters_, rollouts_[r].contact_parameters_, tmp_rollout_cost_);
+            evaluation_manager_->evaluate(tmp_rollout_cost_);
+            rollout_costs_.row(r) = tmp_rollout_cost_.transpose();
+        }
+        // the noiseless rollout and the final trajectory are evaluated in double
+        evaluation_manager_->setSinglePrecision(false);
+        return;
+    }
+
+    // evaluate all rollouts concurrently.
+    // the nested parallel loops in the evaluation run on the calling thread.
+    #pragma omp parallel for schedule(dynamic)
+    for (int r = 0; r < num_rollouts_; ++r)
+    {
+        int slot = rollout_slots_[r];
+        EvaluationManager* evaluation_manager = rollout_evaluation_managers_[slot].get();
+        evaluation_manager->setSinglePrecision(single_precision);
+        evaluation_manager->setTrajectory(rollouts_.getSlot(rollouts_.parameters_, slot),
+                                          rollouts_.getSlot(rollouts_.contact_parameters_, slot));
+        evaluation_manager->evaluate(tmp_rollout_costs_[r]);
+        rollout_costs_.row(r) = tmp_rollout_costs_[r].transpose();
+    }
+}
+
+void ImprovementManagerChomp::printStatistics() const
+{
+    if (num_ranking_checks_ == 0)
+        return;
+    ROS_INFO("Float rollout evaluation : ranking changed in %d of %d iterations, best rollout changed in %d",
+             num_ranking_changes_, num_ranking_checks_, num_best_rollout_changes_);
+}
+
 bool ImprovementManagerChomp::generateRollouts(const std::vector<double>& noise_stddev,
         const std::vector<double>& contact_noise_stddev)
 {
@@ -369,51 +372,45 @@ bool ImprovementManagerChomp::generateRollouts(const std::vector<double>& noise_
         rollout_cost_sorter_.clear();
         for (int r = 0; r < num_rollouts_; ++r)
         {
-            double cost = rollouts_[r].getCost();
+            double cost = rollouts_.getCost(rollout_slots_[r]);
             rollout_cost_sorter_.push_back(std::make_pair(cost, r));
         }
         if (extra_rollouts_added_)
         {
-            for (int r = 0; r < num_rollouts_extra_; ++r)
+            for (int r = num_rollouts_; r < num_rollouts_ + num_rollouts_extra_; ++r)
             {
-                double cost = extra_rollouts_[r].getCost();
-                rollout_cost_sorter_.push_back(std::make_pair(cost, -r - 1));
-                // index is -ve if rollout is taken from extra_rollouts
+                double cost = rollouts_.getCost(rollout_slots_[r]);
+                rollout_cost_sorter_.push_back(std::make_pair(cost, r));
+                // index is >= num_rollouts if rollout is taken from the extra rollouts
             }
             extra_rollouts_added_ = false;
         }
         std::sort(rollout_cost_sorter_.begin(), rollout_cost_sorter_.end());
 
-        // use the best ones: (copy them into reused_rollouts)
+        // use the best ones: their slots move to the end of the rollouts without copying,
+        // and the remaining slots are regenerated or hold the next extra rollouts
+        tmp_rollout_slots_ = rollout_slots_;
+        std::fill(tmp_rollout_reused_.begin(), tmp_rollout_reused_.end(), 0);
         for (int r = 0; r < num_rollouts_reused_; ++r)
         {
-            double reuse_index = rollout_cost_sorter_[r].second;
-
-            //ROS_INFO("Reuse %d, cost = %lf", r, reuse_cost);
-
-            if (reuse_index >= 0)
-                reused_rollouts_[r] = rollouts_[reuse_index];
-            else
-            {
-                //ROS_INFO("Reused noise-less rollout of cost %f", reuse_cost);
-                reused_rollouts_[r] = extra_rollouts_[-reuse_index - 1];
-            }
+            int reuse_index = rollout_cost_sorter_[r].second;
+            rollout_slots_[num_rollouts_gen_ + r] = tmp_rollout_slots_[reuse_index];
+            tmp_rollout_reused_[reuse_index] = 1;
         }
-        // copy them back from reused_rollouts_ into rollouts_
-        for (int r = 0; r < num_rollouts_reused_; ++r)
+        int free_index = 0;
+        for (int i = 0; i < (int) tmp_rollout_slots_.size(); ++i)
         {
-            rollouts_[num_rollouts_gen_ + r] = reused_rollouts_[r];
+            if (tmp_rollout_reused_[i])
+                continue;
+            if (free_index == num_rollouts_gen_)
+                free_index = num_rollouts_;
+            rollout_slots_[free_index++] = tmp_rollout_slots_[i];
+        }
 
-            // update the noise based on the new parameters:
-            for (int d = 0; d < num_dimensions_; ++d)
-            {
-                rollouts_[num_rollouts_gen_ + r].noise_[d] = rollouts_[num_rollouts_gen_ + r].parameters_[d] - parameters_[d];
-            }
-            for (int d = 0; d < num_contact_dimensions_; ++d)
-            {
-                rollouts_[num_rollouts_gen_ + r].contact_noise_[d] = rollouts_[num_rollouts_gen_ + r].contact_parameters_[d]
-                        - contact_parameters_[d];
-            }
+        // update the noise based on the new parameters:
+        for (int r = num_rollouts_gen_; r < num_rollouts_; ++r)
+        {
+            computeNoise(rollout_slots_[r]);
         }
         rollouts_reused_ = true;
     }
@@ -421,35 +418,38 @@ bool ImprovementManagerChomp::generateRollouts(const std::vector<double>& noise_
     // generate new rollouts
     for (int d = 0; d < num_dimensions_; ++d)
     {
+        noise_generators_[d].sample(tmp_noise_, num_rollouts_gen_);
         for (int r = 0; r < num_rollouts_gen_; ++r)
         {
-            noise_generators_[d].sample(tmp_noise_[d]);
+            int column = rollout_slots_[r] * num_dimensions_ + d;
             if (r == 0 && keep_one)
-                rollouts_[r].noise_[d].setZero(rollouts_[r].noise_[d].rows(), rollouts_[r].noise_[d].cols());
+                rollouts_.noise_.col(column).setZero();
             else
-                rollouts_[r].noise_[d] = noise_stddev[d] * tmp_noise_[d];
-
-            rollouts_[r].parameters_[d] = parameters_[d] + rollouts_[r].noise_[d];
+                rollouts_.noise_.col(column) = noise_stddev[d] * tmp_noise_.row(r).transpose();
         }
     }
     // contact
-    const double maxContactValue = PlanningParameters::getInstance()->getContactVariableInitialValues()[0];
     for (int d = 0; d < num_contact_dimensions_; ++d)
     {
+        contact_noise_generators_[d].sample(tmp_contact_noise_, num_rollouts_gen_);
         for (int r = 0; r < num_rollouts_gen_; ++r)
         {
-            contact_noise_generators_[d].sample(tmp_contact_noise_[d]);
-            rollouts_[r].contact_noise_[d] = contact_noise_stddev[d] * tmp_contact_noise_[d];
-            for (int i = 0; i < tmp_contact_noise_[d].rows(); ++i)
-            {
-                if (rollouts_[r].contact_noise_[d](i) + contact_parameters_[d](i) > maxContactValue)
-                    rollouts_[r].contact_noise_[d](i) = maxContactValue - contact_parameters_[d](i);
-                else if (rollouts_[r].contact_noise_[d](i) + contact_parameters_[d](i) < 0)
-                    rollouts_[r].contact_noise_[d](i) = -contact_parameters_[d](i);
-            }
-            rollouts_[r].contact_parameters_[d] = contact_parameters_[d] + rollouts_[r].contact_noise_[d];
+            int column = rollout_slots_[r] * num_contact_dimensions_ + d;
+            rollouts_.contact_noise_.col(column) = contact_noise_stddev[d] * tmp_contact_noise_.row(r).transpose();
         }
     }
+    const double maxContactValue = PlanningParameters::getInstance()->getContactVariableInitialValues()[0];
+    for (int r = 0; r < num_rollouts_gen_; ++r)
+    {
+        int slot = rollout_slots_[r];
+        rollouts_.getSlot(rollouts_.parameters_, slot) = parameters_ + rollouts_.getSlot(rollouts_.noise_, slot);
+
+        // keep the contact variables within [0, maxContactValue]
+        Eigen::Block<MatrixXd> contact_noise = rollouts_.getSlot(rollouts_.contact_noise_, slot);
+        contact_noise = contact_noise.array().min(maxContactValue - contact_parameters_.array()).max(
+                            -contact_parameters_.array()).matrix();
+        rollouts_.getSlot(rollouts_.contact_parameters_, slot) = contact_parameters_ + contact_noise;
+    }
 
     return true;
 }
@@ -473,45 +473,48 @@ void ImprovementManagerChomp::copyGroupTrajectory()
     }
 }
 
-void ImprovementManagerChomp::computeRolloutControlCost(Rollout& rollout)
+void ImprovementManagerChomp::computeRolloutControlCost(int slot)
 {
     // this measures the accelerations and squares them
+    Eigen::Block<MatrixXd> parameters = rollouts_.getSlot(rollouts_.parameters_, slot);
+    Eigen::Block<MatrixXd> noise_projected = rollouts_.getSlot(rollouts_.noise_projected_, slot);
+    Eigen::Block<MatrixXd> control_costs = rollouts_.getSlot(rollouts_.control_costs_, slot);
+    control_costs.setZero();
+    const int half_length = DIFF_RULE_LENGTH / 2;
     for (int d = 0; d < num_dimensions_; ++d)
     {
-        VectorXd params_all = parameters_all_[d];
-        VectorXd costs_all = VectorXd::Zero(num_vars_all_);
+        tmp_parameters_all_ = parameters_all_[d];
+        tmp_parameters_all_.segment(free_vars_start_index_, num_vars_free_) = parameters.col(d) + noise_projected.col(d);
 
-        params_all.segment(free_vars_start_index_, num_vars_free_) = rollout.parameters_[d] + rollout.noise_projected_[d];
-        VectorXd acc_all = VectorXd::Zero(num_vars_all_);
+        // only the free variables are costed, and their stencils stay inside the parameters
         for (int i = 0; i < NUM_DIFF_RULES; ++i)
         {
-            acc_all = differentiation_matrices_[i] * params_all;
-            costs_all += control_cost_weight_ * PlanningParameters::getInstance()->getSmoothnessCosts()[i]
-                         * (acc_all.cwiseProduct(acc_all));
-        }
-
-        rollout.control_costs_[d] = costs_all.segment(free_vars_start_index_, num_vars_free_);
-        /*
-        for (int i = 0; i < free_vars_start_index_; ++i)
-        {
-          rollout.control_costs_[d](0) += costs_all(i);
-          rollout.control_costs_[d](num_vars_free_ - 1) += costs_all(num_vars_all_ - (i + 1));
+            double weight = control_cost_weight_ * PlanningParameters::getInstance()->getSmoothnessCosts()[i];
+            if (weight == 0.0)
+                continue;
+            const double* stencil = differentiation_stencils_[i];
+            for (int t = 0; t < num_vars_free_; ++t)
+            {
+                const double* params = &tmp_parameters_all_(free_vars_start_index_ + t - half_length);
+                double acc = 0.0;
+                for (int j = 0; j < DIFF_RULE_LENGTH; ++j)
+                    acc += stencil[j] * params[j];
+                control_costs(t, d) += weight * acc * acc;
+            }
         }
-        */
     }
-
 }
 
 bool ImprovementManagerChomp::setRolloutCosts()
 {
     for (int r = 0; r < num_rollouts_; ++r)
     {
-        computeRolloutControlCost(rollouts_[r]);
+        computeRolloutControlCost(rollout_slots_[r]);
     }
 
     for (int r = 0; r < num_rollouts_gen_; ++r)
     {
-        rollouts_[r].state_costs_ = rollout_costs_.row(r).transpose();
+        rollouts_.state_costs_.col(rollout_slots_[r]) = rollout_costs_.row(r).transpose();
     }
 
     return true;
@@ -526,20 +529,20 @@ void ImprovementManagerChomp::computeUpdates()
 
 bool ImprovementManagerChomp::computeRolloutCumulativeCosts()
 {
+    // total costs of every slot at each timestep. the extra rollout slots are computed along
+    // so the whole tensor is handled at once, and are not used
+    rollouts_.cumulative_costs_ = rollouts_.control_costs_;
+    for (int s = 0; s < rollouts_.getNumSlots(); ++s)
+    {
+        rollouts_.getSlot(rollouts_.cumulative_costs_, s).colwise() += rollouts_.state_costs_.col(s);
+    }
+
     // compute cumulative costs at each timestep
-    for (int r = 0; r < num_rollouts_; ++r)
+    if (use_cumulative_costs_)
     {
-        for (int d = 0; d < num_dimensions_; ++d)
+        for (int t = num_time_steps_ - 2; t >= 0; --t)
         {
-            rollouts_[r].total_costs_[d] = rollouts_[r].state_costs_ + rollouts_[r].control_costs_[d];
-            rollouts_[r].cumulative_costs_[d] = rollouts_[r].total_costs_[d];
-            if (use_cumulative_costs_)
-            {
-                for (int t = num_time_steps_ - 2; t >= 0; --t)
-                {
-                    rollouts_[r].cumulative_costs_[d](t) += rollouts_[r].cumulative_costs_[d](t + 1);
-                }
-            }
+            rollouts_.cumulative_costs_.row(t) += rollouts_.cumulative_costs_.row(t + 1);
         }
     }
     return true;
@@ -547,57 +550,43 @@ bool ImprovementManagerChomp::computeRolloutCumulativeCosts()
 
 bool ImprovementManagerChomp::computeRolloutProbabilities()
 {
-    for (int d = 0; d < num_dimensions_; ++d)
+    // find min and max cost over all rollouts, for every joint and timestep at once:
+    tmp_min_cost_ = rollouts_.getSlot(rollouts_.cumulative_costs_, rollout_slots_[0]);
+    tmp_max_cost_ = tmp_min_cost_;
+    for (int r = 1; r < num_rollouts_; ++r)
     {
-        for (int t = 0; t < num_time_steps_; t++)
-        {
-
-            // find min and max cost over all rollouts:
-            double min_cost = rollouts_[0].cumulative_costs_[d](t);
-            double max_cost = min_cost;
-            for (int r = 1; r < num_rollouts_; ++r)
-            {
-                double c = rollouts_[r].cumulative_costs_[d](t);
-                if (c < min_cost)
-                    min_cost = c;
-                if (c > max_cost)
-                    max_cost = c;
-            }
-
-            double denom = max_cost - min_cost;
+        const Eigen::Block<MatrixXd> costs = rollouts_.getSlot(rollouts_.cumulative_costs_, rollout_slots_[r]);
+        tmp_min_cost_ = tmp_min_cost_.cwiseMin(costs);
+        tmp_max_cost_ = tmp_max_cost_.cwiseMax(costs);
+    }
 
-            time_step_weights_[d][t] = denom;
+    time_step_weights_ = tmp_max_cost_ - tmp_min_cost_;
 
-            // prevent divide by zero:
-            if (denom < 1e-8)
-                denom = 1e-8;
+    // prevent divide by zero:
+    tmp_inv_cost_range_ = time_step_weights_.cwiseMax(1e-8).cwiseInverse();
 
-            double p_sum = 0.0;
-            for (int r = 0; r < num_rollouts_; ++r)
-            {
-                // the -10.0 here is taken from the paper:
-                rollouts_[r].probabilities_[d](t) = exp(-10.0 * (rollouts_[r].cumulative_costs_[d](t) - min_cost) / denom);
-                p_sum += rollouts_[r].probabilities_[d](t);
-            }
-            for (int r = 0; r < num_rollouts_; ++r)
-            {
-                rollouts_[r].probabilities_[d](t) /= p_sum;
-            }
-
-        }
+    // the -10.0 here is taken from the paper:
+    tmp_sum_rollout_probabilities_.setZero();
+    for (int r = 0; r < num_rollouts_; ++r)
+    {
+        int slot = rollout_slots_[r];
+        Eigen::Block<MatrixXd> probabilities = rollouts_.getSlot(rollouts_.probabilities_, slot);
+        probabilities = -10.0 * (rollouts_.getSlot(rollouts_.cumulative_costs_, slot) - tmp_min_cost_).cwiseProduct(
+                            tmp_inv_cost_range_);
+        // the block of a slot is contiguous, and the exponents are in [-10, 0]
+        expInPlace(probabilities.data(), probabilities.size());
+        tmp_sum_rollout_probabilities_ += probabilities;
     }
-
-    for (int t = 0; t < num_contact_time_steps_; t++)
+    tmp_sum_rollout_probabilities_ = tmp_sum_rollout_probabilities_.cwiseInverse();
+    for (int r = 0; r < num_rollouts_; ++r)
     {
-        for (int r = 0; r < num_rollouts_; ++r)
-        {
-            rollouts_[r].contact_probabilities_(t) = 0.0;
-            for (int d = 0; d < num_dimensions_; ++d)
-            {
-                rollouts_[r].contact_probabilities_(t) += rollouts_[r].probabilities_[d](t);
-            }
-            rollouts_[r].contact_probabilities_(t) /= num_dimensions_;
-        }
+        int slot = rollout_slots_[r];
+        Eigen::Block<MatrixXd> probabilities = rollouts_.getSlot(rollouts_.probabilities_, slot);
+        probabilities = probabilities.cwiseProduct(tmp_sum_rollout_probabilities_);
+
+        // the contact probability is the mean over the joints
+        rollouts_.contact_probabilities_.col(slot) = probabilities.topRows(num_contact_time_steps_).rowwise().sum()
+                / num_dimensions_;
     }
 
     return true;
@@ -605,39 +594,32 @@ bool ImprovementManagerChomp::computeRolloutProbabilities()
 
 bool ImprovementManagerChomp::computeParameterUpdates()
 {
-    for (int d = 0; d < num_dimensions_; ++d)
+    parameter_updates_.setZero();
+    for (int r = 0; r < num_rollouts_; ++r)
     {
-        parameter_updates_[d] = MatrixXd::Zero(num_time_steps_, num_time_steps_);
-
-        for (int r = 0; r < num_rollouts_; ++r)
-        {
-            parameter_updates_[d].row(0).transpose() += rollouts_[r].noise_[d].cwiseProduct(rollouts_[r].probabilities_[d]);
-        }
+        int slot = rollout_slots_[r];
+        parameter_updates_ += rollouts_.getSlot(rollouts_.noise_, slot).cwiseProduct(
+                                  rollouts_.getSlot(rollouts_.probabilities_, slot));
+    }
 
-        // reweighting the updates per time-step
-        double weight = 0.0;
-        double weight_sum = 0.0;
-        for (int t = 0; t < num_time_steps_; ++t)
-        {
-            weight = time_step_weights_[d][t];
-            weight_sum += weight;
-            parameter_updates_[d](0, t) *= weight;
-        }
+    // reweighting the updates per time-step
+    parameter_updates_ = parameter_updates_.cwiseProduct(time_step_weights_);
+    for (int d = 0; d < num_dimensions_; ++d)
+    {
+        double weight_sum = time_step_weights_.col(d).sum();
         if (weight_sum < 1e-6)
             weight_sum = 1e-6;
-        parameter_updates_[d].row(0) *= num_time_steps_ / weight_sum;
-
-        parameter_updates_[d].row(0).transpose() = projection_matrix_[d] * parameter_updates_[d].row(0).transpose();
+        parameter_updates_.col(d) *= num_time_steps_ / weight_sum;
     }
 
-    for (int d = 0; d < num_contact_dimensions_; ++d)
-    {
-        contact_parameter_updates_[d] = VectorXd::Zero(num_contact_time_steps_);
+    projectUpdates(parameter_updates_.block(0, 0, num_time_steps_, num_dimensions_));
 
-        for (int r = 0; r < num_rollouts_; ++r)
-        {
-            contact_parameter_updates_[d] += rollouts_[r].contact_noise_[d].cwiseProduct(rollouts_[r].contact_probabilities_);
-        }
+    contact_parameter_updates_.setZero();
+    for (int r = 0; r < num_rollouts_; ++r)
+    {
+        int slot = rollout_slots_[r];
+        contact_parameter_updates_ += (rollouts_.getSlot(rollouts_.contact_noise_, slot).array().colwise()
+                                       * rollouts_.contact_probabilities_.col(slot).array()).matrix();
     }
     return true;
 }
@@ -647,13 +629,13 @@ bool ImprovementManagerChomp::updateParameters()
     double divisor = 1.0;
     for (int d = 0; d < num_dimensions_; ++d)
     {
-        parameters_all_[d].segment(free_vars_start_index_, num_vars_free_).transpose() += divisor
-                * parameter_updates_[d].row(0);
+        parameters_all_[d].segment(free_vars_start_index_, num_vars_free_) += divisor
+                * parameter_updates_.col(d);
     }
     for (int d = 0; d < num_contact_dimensions_; ++d)
     {
         contact_parameters_all_[d].segment(free_contact_vars_start_index_, num_contact_vars_free_) += divisor
-                * contact_parameter_updates_[d];
+                * contact_parameter_updates_.col(d);
     }
 
     return true;
@@ -664,50 +646,44 @@ void ImprovementManagerChomp::getParameters()
     // save the latest policy parameters:
     for (int d = 0; d < num_dimensions_; ++d)
     {
-        parameters_[d] = parameters_all_[d].segment(free_vars_start_index_, num_vars_free_);
+        parameters_.col(d) = parameters_all_[d].segment(free_vars_start_index_, num_vars_free_);
     }
     for (int d = 0; d < num_contact_dimensions_; ++d)
     {
-        contact_parameters_[d] = contact_parameters_all_[d].segment(free_contact_vars_start_index_, num_contact_vars_free_);
+        contact_parameters_.col(d) = contact_parameters_all_[d].segment(free_contact_vars_start_index_, num_contact_vars_free_);
     }
 }
 
-void ImprovementManagerChomp::addExtraRollout(std::vector<Eigen::VectorXd>& parameters,
-        std::vector<Eigen::VectorXd>& contact_parameters, Eigen::VectorXd& costs)
+void ImprovementManagerChomp::addExtraRollout(const Eigen::MatrixXd& parameters,
+        const Eigen::MatrixXd& contact_parameters, const Eigen::VectorXd& costs)
 {
-    for (int r = 0; r < num_rollouts_extra_; ++r)
+    for (int r = num_rollouts_; r < num_rollouts_ + num_rollouts_extra_; ++r)
     {
-        extra_rollouts_[r].parameters_ = parameters;
-        extra_rollouts_[r].contact_parameters_ = contact_parameters;
-        extra_rollouts_[r].state_costs_ = costs;
-        computeNoise(extra_rollouts_[r]);
-        computeProjectedNoise(extra_rollouts_[r]);
-        computeRolloutControlCost(extra_rollouts_[r]);
+        int slot = rollout_slots_[r];
+        rollouts_.getSlot(rollouts_.parameters_, slot) = parameters;
+        rollouts_.getSlot(rollouts_.contact_parameters_, slot) = contact_parameters;
+        rollouts_.state_costs_.col(slot) = costs;
+        computeNoise(slot);
+        computeProjectedNoise(slot);
+        computeRolloutControlCost(slot);
     }
 
     extra_rollouts_added_ = true;
 }
 
-bool ImprovementManagerChomp::computeNoise(Rollout& rollout)
+bool ImprovementManagerChomp::computeNoise(int slot)
 {
-    for (int d = 0; d < num_dimensions_; ++d)
-    {
-        rollout.noise_[d] = rollout.parameters_[d] - parameters_[d];
-    }
-    for (int d = 0; d < num_contact_dimensions_; ++d)
-    {
-        rollout.contact_noise_[d] = rollout.contact_parameters_[d] - contact_parameters_[d];
-    }
+    rollouts_.getSlot(rollouts_.noise_, slot) = rollouts_.getSlot(rollouts_.parameters_, slot) - parameters_;
+    rollouts_.getSlot(rollouts_.contact_noise_, slot) = rollouts_.getSlot(rollouts_.contact_parameters_, slot)
+            - contact_parameters_;
     return true;
 }
 
-bool ImprovementManagerChomp::computeProjectedNoise(Rollout& rollout)
+bool ImprovementManagerChomp::computeProjectedNoise(int slot)
 {
-    for (int d = 0; d < num_dimensions_; ++d)
-    {
-        rollout.noise_projected_[d] = projection_matrix_[d] * rollout.noise_[d];
-        //rollout.parameters_noise_projected_[d] = rollout.parameters_[d] + rollout.noise_projected_[d];
-    }
+    Eigen::Block<MatrixXd> noise_projected = rollouts_.getSlot(rollouts_.noise_projected_, slot);
+    noise_projected = rollouts_.getSlot(rollouts_.noise_, slot);
+    projectUpdates(noise_projected);
 
     return true;
 }
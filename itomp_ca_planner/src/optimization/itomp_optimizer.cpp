@@ -125,8 +125,10 @@ bool ItompOptimizer::optimize()
             //ROS_INFO("Iteration time : %f", elapsed);
 
 
-			is_feasible = evaluation_manager_.isLastTrajectoryFeasible();
             bool is_updated = updateBestTrajectory(evaluation_manager_.getTrajectoryCost(true));
+			// approximate collision results are only confirmed when the trajectory becomes the best one
+			is_feasible = is_updated ? evaluation_manager_.checkLastTrajectoryFeasibility()
+					: evaluation_manager_.isLastTrajectoryFeasible();
 
             bool is_best_trajectory = best_cost_manager_->updateBestCost(trajectory_index_, best_group_trajectory_cost_,
                                       is_feasible);
@@ -159,17 +161,22 @@ bool ItompOptimizer::optimize()
 	group_trajectory_.getContactTrajectory() = best_group_contact_trajectory_;
 	evaluation_manager_.updateFullTrajectory();
 
+	// the returned trajectory is evaluated and checked exactly
+	evaluation_manager_.resetIncrementalEvaluation();
+	evaluation_manager_.evaluate();
+	is_feasible = evaluation_manager_.checkLastTrajectoryFeasibility();
 	if (best_cost_manager_->getBestCostTrajectoryIndex() == trajectory_index_)
-	{
-		evaluation_manager_.evaluate();
 		evaluation_manager_.printDebugInfo();
-	}
 
     evaluation_manager_.render(trajectory_index_, best_cost_manager_->getBestCostTrajectoryIndex()
                                == trajectory_index_);
 
     ROS_INFO("Terminated after %d iterations, using path from iteration %d", iteration_, last_improvement_iteration_);
     ROS_INFO("Optimization core finished in %f sec", (ros::WallTime::now() - start_time).toSec());
+    if (evaluation_manager_.getCollisionCache())
+        ROS_INFO("Collision cache : %ld hits, %ld misses", evaluation_manager_.getCollisionCache()->getNumHits(),
+                 evaluation_manager_.getCollisionCache()->getNumMisses());
+    improvement_manager_->printStatistics();
 
 	//evaluation_manager_.getTrajectoryCost(true);
 
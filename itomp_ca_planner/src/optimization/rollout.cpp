@@ -39,12 +39,31 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 
 namespace itomp_ca_planner
 {
-double Rollout::getCost()
+Rollouts::Rollouts() :
+		num_slots_(0)
 {
-	double cost = state_costs_.sum();
-	int num_dim = control_costs_.size();
-	for (int d = 0; d < num_dim; ++d)
-		cost += control_costs_[d].sum();
-	return cost;
+}
+
+void Rollouts::resize(int num_slots, int num_dimensions, int num_time_steps, int num_contact_dimensions,
+		int num_contact_time_steps)
+{
+	num_slots_ = num_slots;
+
+	parameters_ = Eigen::MatrixXd::Zero(num_time_steps, num_slots * num_dimensions);
+	noise_ = Eigen::MatrixXd::Zero(num_time_steps, num_slots * num_dimensions);
+	noise_projected_ = Eigen::MatrixXd::Zero(num_time_steps, num_slots * num_dimensions);
+	state_costs_ = Eigen::MatrixXd::Zero(num_time_steps, num_slots);
+	control_costs_ = Eigen::MatrixXd::Zero(num_time_steps, num_slots * num_dimensions);
+	cumulative_costs_ = Eigen::MatrixXd::Zero(num_time_steps, num_slots * num_dimensions);
+	probabilities_ = Eigen::MatrixXd::Zero(num_time_steps, num_slots * num_dimensions);
+
+	contact_parameters_ = Eigen::MatrixXd::Zero(num_contact_time_steps, num_slots * num_contact_dimensions);
+	contact_noise_ = Eigen::MatrixXd::Zero(num_contact_time_steps, num_slots * num_contact_dimensions);
+	contact_probabilities_ = Eigen::MatrixXd::Zero(num_contact_time_steps, num_slots);
+}
+
+double Rollouts::getCost(int slot) const
+{
+	return state_costs_.col(slot).sum() + getSlot(control_costs_, slot).sum();
 }
 }
@@ -40,6 +40,7 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <itomp_ca_planner/util/planning_parameters.h>
 #include <itomp_ca_planner/visualization/visualization_manager.h>
 #include <itomp_ca_planner/precomputation/precomputation.h>
+#include <itomp_ca_planner/cost/signed_distance_field.h>
 #include <kdl/jntarray.hpp>
 #include <angles/angles.h>
 #include <visualization_msgs/MarkerArray.h>
@@ -124,6 +125,8 @@ bool ItompPlannerNode::planKinematicPath(const planning_scene::PlanningSceneCons
 	getPlanningGroups(planningGroups, req.group_name);
 
     Precomputation::getInstance()->initialize(planning_scene, robot_model_, req.group_name);
+    if (PlanningParameters::getInstance()->getUseSDFCollisionCost())
+        SignedDistanceField::getInstance()->initialize(planning_scene, robot_model_);
 
 
 	int num_trials = PlanningParameters::getInstance()->getNumTrials();
@@ -178,6 +181,8 @@ bool ItompPlannerNode::plan3StepPath(const planning_scene::PlanningSceneConstPtr
         return false;
 
     Precomputation::getInstance()->initialize(planning_scene, robot_model_, req.group_name);
+    if (PlanningParameters::getInstance()->getUseSDFCollisionCost())
+        SignedDistanceField::getInstance()->initialize(planning_scene, robot_model_);
     Precomputation::getInstance()->createRoadmap();
 
     complete_initial_robot_state_ = planning_scene->getCurrentStateUpdated(req.start_state);
@@ -298,6 +303,18 @@ bool ItompPlannerNode::preprocessRequest(const planning_interface::MotionPlanReq
         ROS_INFO("%s %f", goal_joint_states[0].name[i].c_str(), goal_joint_states[0].position[i]);
 	}
 
+	// cartesian path constraints need the tool link in the KDL tree
+	if (req.path_constraints.position_constraints.size() != 0
+			&& PlanningParameters::getInstance()->getCartesianTrajectoryCostWeight() != 0.0)
+	{
+		const std::string& tool_link = PlanningParameters::getInstance()->getCartesianTrajectoryToolLink();
+		if (robot_model_.getSegmentIndex(tool_link) == -1)
+		{
+			ROS_ERROR("Cartesian trajectory tool link %s is not in the robot model", tool_link.c_str());
+			return false;
+		}
+	}
+
     ROS_INFO_STREAM("Joint state has " << req.start_state.joint_state.name.size() << " joints");
 
 	return true;
@@ -39,6 +39,7 @@ Any questions or comments should be sent to the author chpark@cs.unc.edu
 #include <itomp_ca_planner/trajectory/itomp_cio_trajectory.h>
 #include <itomp_ca_planner/model/itomp_robot_model.h>
 #include <itomp_ca_planner/model/itomp_planning_group.h>
+#include <itomp_ca_planner/model/damped_ik_solver.h>
 #include <itomp_ca_planner/util/planning_parameters.h>
 #include <ros/console.h>
 #include <ros/assert.h>
@@ -532,10 +533,12 @@ void ItompCIOTrajectory::fillInMinJerkCartesianTrajectory(
     const moveit_msgs::Constraints& path_constraints,
     const string& group_name)
 {
-	robot_state::RobotStatePtr kinematic_state(
-        new robot_state::RobotState(robot_model_->getRobotModel()));
-	const robot_state::JointModelGroup* joint_model_group =
-        robot_model_->getRobotModel()->getJointModelGroup(group_name);
+	const ItompPlanningGroup* planning_group = robot_model_->getPlanningGroup(group_name);
+	if (planning_group == NULL || !planning_group->jacobian_.isValid())
+	{
+		ROS_ERROR("Cartesian trajectory of group %s is not supported", group_name.c_str());
+		return;
+	}
 
 	geometry_msgs::Vector3 start_position =
         path_constraints.position_constraints[0].target_point_offset;
@@ -550,14 +553,13 @@ void ItompCIOTrajectory::fillInMinJerkCartesianTrajectory(
 	double end_index = end_index_ + 1;
 	double duration = (end_index - start_index) * discretization_;
 
-	// set state to the start config
-	std::vector<double> positions(num_joints_);
+	// IK is seeded from the start config
+	ROS_ASSERT(num_joints_ == robot_model_->getNumKDLJoints());
+	KDL::JntArray seed(num_joints_);
 	for (std::size_t k = 0; k < num_joints_; k++)
 	{
-		positions[k] = (*this)(start_index, k);
+		seed(k) = (*this)(start_index, k);
 	}
-	kinematic_state->setVariablePositions(&positions[0]);
-	kinematic_state->update();
 
 	double T[6]; // powers of the time duration
 	T[0] = 1.0;
@@ -604,8 +606,15 @@ void ItompCIOTrajectory::fillInMinJerkCartesianTrajectory(
 		coeff[i][5] = (-0.5 * a0 - 3 * v0 - 6 * x0 + 6 * x1);
 	}
 
+	Eigen::Quaternion<double> rot(orientation.w, orientation.x,
+                                  orientation.y, orientation.z);
+	Eigen::Matrix3d mat = rot.toRotationMatrix();
+	KDL::Rotation target_orientation(mat(0, 0), mat(0, 1), mat(0, 2), mat(1, 0), mat(1, 1), mat(1, 2),
+			mat(2, 0), mat(2, 1), mat(2, 2));
+
 	// now evaluate 3d pos for each pos
 	int numPoints = end_index - start_index;
+	std::vector<KDL::Frame> targets(numPoints + 1);
 	for (int i = start_index; i <= end_index; i++)
 	{
 		double t[6]; // powers of the time index point
@@ -624,58 +633,24 @@ void ItompCIOTrajectory::fillInMinJerkCartesianTrajectory(
 				pos[j] += t[k] * coeff[j][k];
 			}
 		}
-		geometry_msgs::Vector3 position;
-		position.x = pos[0];
-		position.y = pos[1];
-		position.z = pos[2];
-
-		// Use IK to compute joint values
-		vector<double> ik_solution(num_joints_);
-
-		Eigen::Affine3d end_effector_state = Eigen::Affine3d::Identity();
-		Eigen::Quaternion<double> rot(orientation.w, orientation.x,
-                                      orientation.y, orientation.z);
-		Eigen::Vector3d trans(position.x, position.y, position.z);
-		Eigen::Matrix3d mat = rot.toRotationMatrix();
-		end_effector_state.linear() = mat;
-		end_effector_state.translation() = trans;
-
-		kinematics::KinematicsQueryOptions options;
-		options.return_approximate_solution = true;
-		bool found_ik = false;
-		while (found_ik == false)
-		{
-			found_ik = kinematic_state->setFromIK(joint_model_group,
-                                                  end_effector_state, 10, 0.1,
-                                                  moveit::core::GroupStateValidityCallbackFn(), options);
-			if (found_ik)
-			{
-				//ROS_INFO("IK solution found for waypoint %d", i);
-
-				std::vector<double> group_values;
-				kinematic_state->copyJointGroupPositions(joint_model_group,
-						group_values);
-				double* state_pos = kinematic_state->getVariablePositions();
-				ROS_ASSERT(num_joints_ == kinematic_state->getVariableCount());
-				//printf("EE : (%f %f %f)(%f %f %f %f) : ", position.x, position.y, position.z, orientation.x, orientation.y,
-				//  orientation.z, orientation.w);
-				for (std::size_t k = 0; k < kinematic_state->getVariableCount();
-						++k)
-				{
-					ik_solution[k] = state_pos[k];
-					if (i != start_index)
-						(*this)(i, k) = state_pos[k];
-					//printf("%f ", state_pos[k]);
-				}
-				//printf("\n");
-				break;
-			}
-			else
-			{
-				ROS_INFO("Could not find IK solution for waypoint %d", i);
-			}
-		}
+		targets[(int) (i - start_index)] = KDL::Frame(target_orientation, KDL::Vector(pos[0], pos[1], pos[2]));
+	}
+
+	// Use IK to compute joint values
+	Eigen::MatrixXd ik_solutions;
+	std::vector<bool> converged;
+	int num_converged = DampedIkSolver::solvePath(planning_group, targets, seed, ik_solutions, converged);
+	for (int i = start_index; i <= end_index; i++)
+	{
+		int waypoint = i - start_index;
+		if (!converged[waypoint])
+			ROS_INFO("Could not find IK solution for waypoint %d", i);
+		if (waypoint == 0)
+			continue;
+		for (int k = 0; k < num_joints_; k++)
+			(*this)(i, k) = ik_solutions(waypoint, k);
 	}
+	ROS_INFO("IK converged at %d of %d waypoints", num_converged, numPoints + 1);
 }
 
 void ItompCIOTrajectory::printTrajectory() const
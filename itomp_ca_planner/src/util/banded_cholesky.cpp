@@ -0,0 +1,128 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#include <itomp_ca_planner/util/banded_cholesky.h>
+
+namespace itomp_ca_planner
+{
+
+BandedCholesky::BandedCholesky() :
+		size_(0), bandwidth_(0)
+{
+}
+
+bool BandedCholesky::compute(const Eigen::MatrixXd& band)
+{
+	size_ = band.cols();
+	bandwidth_ = std::min<int>(band.rows() - 1, std::max(0, size_ - 1));
+
+	// L(i, j) is zero for i - j > bandwidth
+	cholesky_band_ = Eigen::MatrixXd::Zero(bandwidth_ + 1, size_);
+	for (int j = 0; j < size_; ++j)
+	{
+		double diagonal = band(0, j);
+		for (int k = std::max(0, j - bandwidth_); k < j; ++k)
+			diagonal -= cholesky_band_(j - k, k) * cholesky_band_(j - k, k);
+		if (diagonal <= 0.0)
+			return false;
+		double l_jj = std::sqrt(diagonal);
+		cholesky_band_(0, j) = l_jj;
+
+		int last = std::min(size_ - 1, j + bandwidth_);
+		for (int i = j + 1; i <= last; ++i)
+		{
+			double value = band(i - j, j);
+			for (int k = std::max(0, i - bandwidth_); k < j; ++k)
+				value -= cholesky_band_(i - k, k) * cholesky_band_(j - k, k);
+			cholesky_band_(i - j, j) = value / l_jj;
+		}
+	}
+	return true;
+}
+
+void BandedCholesky::solveInPlace(Eigen::VectorXd& x) const
+{
+	// L y = x
+	for (int j = 0; j < size_; ++j)
+	{
+		double value = x(j);
+		for (int k = std::max(0, j - bandwidth_); k < j; ++k)
+			value -= cholesky_band_(j - k, k) * x(k);
+		x(j) = value / cholesky_band_(0, j);
+	}
+	// L^T x = y
+	for (int j = size_ - 1; j >= 0; --j)
+	{
+		double value = x(j);
+		int last = std::min(size_ - 1, j + bandwidth_);
+		for (int i = j + 1; i <= last; ++i)
+			value -= cholesky_band_(i - j, j) * x(i);
+		x(j) = value / cholesky_band_(0, j);
+	}
+}
+
+void BandedCholesky::solveInPlace(Eigen::Block<Eigen::MatrixXd> columns) const
+{
+	// one variable (row) at a time across all the columns
+	for (int j = 0; j < size_; ++j)
+	{
+		for (int k = std::max(0, j - bandwidth_); k < j; ++k)
+			columns.row(j) -= cholesky_band_(j - k, k) * columns.row(k);
+		columns.row(j) /= cholesky_band_(0, j);
+	}
+	for (int j = size_ - 1; j >= 0; --j)
+	{
+		int last = std::min(size_ - 1, j + bandwidth_);
+		for (int i = j + 1; i <= last; ++i)
+			columns.row(j) -= cholesky_band_(i - j, j) * columns.row(i);
+		columns.row(j) /= cholesky_band_(0, j);
+	}
+}
+
+void BandedCholesky::solveLowerTransposeInPlace(Eigen::Block<Eigen::MatrixXd> rows) const
+{
+	// one variable (column) at a time across all the rows
+	for (int j = size_ - 1; j >= 0; --j)
+	{
+		int last = std::min(size_ - 1, j + bandwidth_);
+		for (int i = j + 1; i <= last; ++i)
+			rows.col(j) -= cholesky_band_(i - j, j) * rows.col(i);
+		rows.col(j) /= cholesky_band_(0, j);
+	}
+}
+
+}
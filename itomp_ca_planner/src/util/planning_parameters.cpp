@@ -69,6 +69,13 @@ void PlanningParameters::initFromNodeHandle()
 	node_handle.param("smoothness_cost_weight", smoothness_cost_weight_,
                       0.0001);
 	node_handle.param("obstacle_cost_weight", obstacle_cost_weight_, 1.0);
+	node_handle.param("use_sdf_collision_cost", use_sdf_collision_cost_, false);
+	node_handle.param("sdf_resolution", sdf_resolution_, 0.02);
+	node_handle.param("sdf_clearance", sdf_clearance_, 0.05);
+	node_handle.param("use_collision_cache", use_collision_cache_, false);
+	node_handle.param("collision_cache_quantum", collision_cache_quantum_, 0.001);
+	node_handle.param("collision_cache_capacity", collision_cache_capacity_, 65536);
+	node_handle.param("use_batch_forward_kinematics", use_batch_forward_kinematics_, false);
 	node_handle.param("torque_cost_weight", torque_cost_weight_, 0.0);
 	node_handle.param("state_validity_cost_weight", state_validity_cost_weight_,
                       1.0);
@@ -83,7 +90,13 @@ void PlanningParameters::initFromNodeHandle()
 	node_handle.param("FTR_cost_weight", ftr_cost_weight_, 1.0);
 	node_handle.param("cartesian_trajectory_cost_weight",
                       cartesian_trajectory_cost_weight_, 1.0);
-	node_handle.param("singularity_cost_weight", singularity_cost_weight_, 1.0);
+	node_handle.param("singularity_cost_weight", singularity_cost_weight_, 0.0);
+	node_handle.param("singularity_manipulability_threshold",
+                      singularity_manipulability_threshold_, 0.01);
+	node_handle.param<std::string>("cartesian_trajectory_tool_link",
+                                   cartesian_trajectory_tool_link_, "tcp_2_link");
+	node_handle.param<std::string>("cartesian_trajectory_flange_link",
+                                   cartesian_trajectory_flange_link_, "segment_7");
 
 	node_handle.param("smoothness_cost_velocity", smoothness_cost_velocity_,
                       0.0);
@@ -186,6 +199,16 @@ void PlanningParameters::initFromNodeHandle()
 	node_handle.param("noise_decay", noise_decay_, 0.999);
 	node_handle.param("use_cumulative_costs", use_cumulative_costs_, true);
 	node_handle.param("use_smooth_noises", use_smooth_noises_, true);
+	node_handle.param("use_parallel_rollout_evaluation",
+                      use_parallel_rollout_evaluation_, true);
+	node_handle.param("use_incremental_evaluation",
+                      use_incremental_evaluation_, true);
+	node_handle.param("incremental_evaluation_tolerance",
+                      incremental_evaluation_tolerance_, 0.0);
+	node_handle.param("use_float_rollout_evaluation",
+                      use_float_rollout_evaluation_, false);
+	node_handle.param("float_rollout_ranking_check",
+                      float_rollout_ranking_check_, false);
 
 	node_handle.param("num_contacts", num_contacts_, 0);
 
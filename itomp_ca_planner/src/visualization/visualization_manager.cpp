@@ -628,7 +628,7 @@ void VisualizationManager::setPlanningGroup(
 }
 
 void VisualizationManager::animateEndeffector(int trajectory_index, int point_start, int point_end,
-		const vector<vector<KDL::Frame> >& segmentFrames, bool best)
+		const ContiguousArray2D<KDL::Frame>& segmentFrames, bool best)
 {
 	const double trajectory_color_diff = 0.33;
 	const double scale = 0.005;
@@ -708,7 +708,7 @@ void VisualizationManager::animateEndeffector(int trajectory_index, int point_st
 }
 
 void VisualizationManager::animateRoot(int numFreeVars, int freeVarStartIndex,
-                                       const std::vector<std::vector<KDL::Frame> >& segmentFrames, bool best)
+                                       const ContiguousArray2D<KDL::Frame>& segmentFrames, bool best)
 {
 	const double scale = 0.05;
 
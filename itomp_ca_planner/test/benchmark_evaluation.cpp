@@ -0,0 +1,116 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+// Times EvaluationManager::evaluate() on a min-jerk trajectory whose free points are
+// perturbed before every evaluation, so each call evaluates the whole trajectory.
+// Run with test/benchmark_evaluation.launch.
+#include <ros/ros.h>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <algorithm>
+#include <cstdio>
+#include "evaluation_setup.h"
+
+using namespace itomp_ca_planner;
+
+int main(int argc, char** argv)
+{
+	ros::init(argc, argv, "benchmark_evaluation");
+	ros::NodeHandle node_handle("~");
+
+	std::string group_name;
+	std::vector<double> goal;
+	int num_evaluations;
+	double noise_stddev;
+	node_handle.param<std::string>("group_name", group_name, "lower_body");
+	node_handle.param("num_evaluations", num_evaluations, 1000);
+	node_handle.param("noise_stddev", noise_stddev, 0.01);
+	if (!node_handle.getParam("goal", goal))
+	{
+		ROS_ERROR("benchmark_evaluation needs the ~goal joint values of the group");
+		return 1;
+	}
+	if (num_evaluations < 1)
+	{
+		ROS_ERROR("~num_evaluations has to be positive");
+		return 1;
+	}
+
+	EvaluationSetup setup;
+	if (!setup.initialize(group_name, goal))
+		return 1;
+
+	EvaluationManager& evaluation_manager = *setup.evaluation_manager_;
+	Eigen::MatrixXd initial_free_points = setup.group_trajectory_->getFreeTrajectoryBlock();
+
+	boost::mt19937 rng(0);
+	boost::variate_generator<boost::mt19937&, boost::normal_distribution<double> > noise(rng,
+			boost::normal_distribution<double>(0.0, noise_stddev));
+
+	// the first evaluation sizes the buffers
+	evaluation_manager.evaluate();
+
+	std::vector<double> times(num_evaluations);
+	double cost_sum = 0.0;
+	for (int n = 0; n < num_evaluations; ++n)
+	{
+		Eigen::Block<Eigen::MatrixXd, Eigen::Dynamic, Eigen::Dynamic> free_points =
+				setup.group_trajectory_->getFreeTrajectoryBlock();
+		for (int i = 0; i < free_points.rows(); ++i)
+			for (int j = 0; j < free_points.cols(); ++j)
+				free_points(i, j) = initial_free_points(i, j) + noise();
+		setup.updateTrajectory();
+
+		ros::WallTime start_time = ros::WallTime::now();
+		cost_sum += evaluation_manager.evaluate();
+		times[n] = (ros::WallTime::now() - start_time).toSec();
+	}
+
+	std::sort(times.begin(), times.end());
+	double total_time = 0.0;
+	for (int n = 0; n < num_evaluations; ++n)
+		total_time += times[n];
+
+	printf("%s: %d points x %d joints, %d evaluations\n", group_name.c_str(),
+			setup.group_trajectory_->getNumPoints(), setup.group_trajectory_->getNumJoints(), num_evaluations);
+	printf("evaluate(): mean %.3f ms, median %.3f ms, min %.3f ms (mean cost %f)\n",
+			total_time / num_evaluations * 1000.0, times[num_evaluations / 2] * 1000.0, times[0] * 1000.0,
+			cost_sum / num_evaluations);
+
+	return 0;
+}
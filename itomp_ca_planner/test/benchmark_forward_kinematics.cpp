@@ -0,0 +1,120 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+// Times the flat-table JntToCartFull of TreeFkSolverJointPosAxisPartial against the recursive
+// TreeFkSolverJointPosAxis::JntToCart on random trees.
+// usage: benchmark_forward_kinematics [num_calls]
+#include <ros/ros.h>
+#include <itomp_ca_planner/model/treefksolverjointposaxis.hpp>
+#include <itomp_ca_planner/model/treefksolverjointposaxis_partial.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include "random_tree.h"
+
+using namespace itomp_ca_planner;
+
+namespace
+{
+const int NUM_CONFIGURATIONS = 64;
+
+double maxDifference(const std::vector<KDL::Vector>& a, const std::vector<KDL::Vector>& b)
+{
+	double difference = 0.0;
+	for (std::size_t i = 0; i < a.size(); ++i)
+		difference = std::max(difference, (a[i] - b[i]).Norm());
+	return difference;
+}
+}
+
+int main(int argc, char** argv)
+{
+	int num_calls = (argc > 1) ? atoi(argv[1]) : 100000;
+	if (num_calls < NUM_CONFIGURATIONS)
+	{
+		fprintf(stderr, "usage: %s [num_calls >= %d]\n", argv[0], NUM_CONFIGURATIONS);
+		return 1;
+	}
+
+	static const int tree_sizes[] = { 8, 16, 32, 64 };
+	printf("segments joints   recursive (us)   flat (us)   speedup   max difference\n");
+	for (int t = 0; t < (int) (sizeof(tree_sizes) / sizeof(tree_sizes[0])); ++t)
+	{
+		RandomTree random_tree(t + 1);
+		KDL::Tree tree;
+		random_tree.build(tree, tree_sizes[t]);
+		int num_joints = tree.getNrOfJoints();
+
+		KDL::TreeFkSolverJointPosAxis recursive_solver(tree, "segment_0");
+		KDL::TreeFkSolverJointPosAxisPartial flat_solver(tree, "segment_0", std::vector<bool>(num_joints, true));
+
+		std::vector<KDL::JntArray> q(NUM_CONFIGURATIONS, KDL::JntArray(num_joints));
+		for (int i = 0; i < NUM_CONFIGURATIONS; ++i)
+			random_tree.randomize(q[i]);
+
+		std::vector<KDL::Vector> joint_pos, joint_axis;
+		std::vector<KDL::Frame> segment_frames;
+		std::vector<KDL::Vector> flat_joint_pos, flat_joint_axis;
+		std::vector<KDL::Frame> flat_segment_frames;
+
+		// both solvers are run once first, so the outputs are sized before the timing
+		recursive_solver.JntToCart(q[0], joint_pos, joint_axis, segment_frames);
+		flat_solver.JntToCartFull(q[0], flat_joint_pos, flat_joint_axis, flat_segment_frames);
+
+		ros::WallTime start_time = ros::WallTime::now();
+		for (int n = 0; n < num_calls; ++n)
+			recursive_solver.JntToCart(q[n % NUM_CONFIGURATIONS], joint_pos, joint_axis, segment_frames);
+		double recursive_time = (ros::WallTime::now() - start_time).toSec();
+
+		start_time = ros::WallTime::now();
+		for (int n = 0; n < num_calls; ++n)
+			flat_solver.JntToCartFull(q[n % NUM_CONFIGURATIONS], &flat_joint_pos[0], &flat_joint_axis[0],
+					&flat_segment_frames[0]);
+		double flat_time = (ros::WallTime::now() - start_time).toSec();
+
+		// the last configuration of both loops is the same
+		double difference = std::max(maxDifference(joint_pos, flat_joint_pos),
+				maxDifference(joint_axis, flat_joint_axis));
+		for (std::size_t i = 0; i < segment_frames.size(); ++i)
+			difference = std::max(difference, (segment_frames[i].p - flat_segment_frames[i].p).Norm());
+
+		printf("%8d %6d %16.3f %11.3f %9.2f %16g\n", tree_sizes[t], num_joints,
+				recursive_time / num_calls * 1e6, flat_time / num_calls * 1e6, recursive_time / flat_time,
+				difference);
+	}
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+// Times the PI^2 rollout probabilities of ImprovementManagerChomp::computeRolloutProbabilities on the
+// Rollouts tensors, with expInPlace and with the Eigen exp it replaced.
+// usage: benchmark_rollout_probabilities [num_time_steps] [num_dimensions] [num_calls]
+#include <ros/ros.h>
+#include <itomp_ca_planner/optimization/rollout.h>
+#include <itomp_ca_planner/util/fast_exp.h>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace itomp_ca_planner;
+
+namespace
+{
+struct ProbabilityBuffers
+{
+	Eigen::MatrixXd min_cost_;
+	Eigen::MatrixXd max_cost_;
+	Eigen::MatrixXd inv_cost_range_;
+	Eigen::MatrixXd sum_probabilities_;
+};
+
+// the same steps as computeRolloutProbabilities, for the first num_rollouts slots
+void computeProbabilities(Rollouts& rollouts, int num_rollouts, bool use_exp_in_place, ProbabilityBuffers& buffers)
+{
+	buffers.min_cost_ = rollouts.getSlot(rollouts.cumulative_costs_, 0);
+	buffers.max_cost_ = buffers.min_cost_;
+	for (int r = 1; r < num_rollouts; ++r)
+	{
+		const Eigen::Block<Eigen::MatrixXd> costs = rollouts.getSlot(rollouts.cumulative_costs_, r);
+		buffers.min_cost_ = buffers.min_cost_.cwiseMin(costs);
+		buffers.max_cost_ = buffers.max_cost_.cwiseMax(costs);
+	}
+	buffers.inv_cost_range_ = (buffers.max_cost_ - buffers.min_cost_).cwiseMax(1e-8).cwiseInverse();
+
+	buffers.sum_probabilities_.setZero();
+	for (int r = 0; r < num_rollouts; ++r)
+	{
+		Eigen::Block<Eigen::MatrixXd> probabilities = rollouts.getSlot(rollouts.probabilities_, r);
+		if (use_exp_in_place)
+		{
+			probabilities = -10.0 * (rollouts.getSlot(rollouts.cumulative_costs_, r) - buffers.min_cost_).cwiseProduct(
+					buffers.inv_cost_range_);
+			expInPlace(probabilities.data(), probabilities.size());
+		}
+		else
+		{
+			probabilities = (-10.0 * (rollouts.getSlot(rollouts.cumulative_costs_, r) - buffers.min_cost_).array()
+					* buffers.inv_cost_range_.array()).exp().matrix();
+		}
+		buffers.sum_probabilities_ += probabilities;
+	}
+	buffers.sum_probabilities_ = buffers.sum_probabilities_.cwiseInverse();
+	for (int r = 0; r < num_rollouts; ++r)
+	{
+		Eigen::Block<Eigen::MatrixXd> probabilities = rollouts.getSlot(rollouts.probabilities_, r);
+		probabilities = probabilities.cwiseProduct(buffers.sum_probabilities_);
+	}
+}
+
+double timeProbabilities(Rollouts& rollouts, int num_rollouts, bool use_exp_in_place, int num_calls,
+		ProbabilityBuffers& buffers)
+{
+	computeProbabilities(rollouts, num_rollouts, use_exp_in_place, buffers);
+	ros::WallTime start_time = ros::WallTime::now();
+	for (int n = 0; n < num_calls; ++n)
+		computeProbabilities(rollouts, num_rollouts, use_exp_in_place, buffers);
+	return (ros::WallTime::now() - start_time).toSec() / num_calls;
+}
+}
+
+int main(int argc, char** argv)
+{
+	int num_time_steps = (argc > 1) ? atoi(argv[1]) : 101;
+	int num_dimensions = (argc > 2) ? atoi(argv[2]) : 7;
+	int num_calls = (argc > 3) ? atoi(argv[3]) : 1000;
+	if (num_time_steps < 1 || num_dimensions < 1 || num_calls < 1)
+	{
+		fprintf(stderr, "usage: %s [num_time_steps] [num_dimensions] [num_calls]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%d time steps x %d dimensions\n", num_time_steps, num_dimensions);
+	printf("rollouts   Eigen exp (us)   expInPlace (us)   speedup   max relative difference\n");
+	static const int rollout_counts[] = { 10, 50, 200 };
+	for (int i = 0; i < (int) (sizeof(rollout_counts) / sizeof(rollout_counts[0])); ++i)
+	{
+		int num_rollouts = rollout_counts[i];
+		Rollouts rollouts;
+		rollouts.resize(num_rollouts, num_dimensions, num_time_steps, 0, num_time_steps);
+		srand(num_rollouts);
+		for (int c = 0; c < rollouts.cumulative_costs_.cols(); ++c)
+			for (int t = 0; t < num_time_steps; ++t)
+				rollouts.cumulative_costs_(t, c) = 100.0 * rand() / RAND_MAX;
+
+		ProbabilityBuffers buffers;
+		buffers.sum_probabilities_.resize(num_time_steps, num_dimensions);
+
+		double eigen_time = timeProbabilities(rollouts, num_rollouts, false, num_calls, buffers);
+		Eigen::MatrixXd eigen_probabilities = rollouts.probabilities_;
+		double exp_in_place_time = timeProbabilities(rollouts, num_rollouts, true, num_calls, buffers);
+
+		double difference = ((rollouts.probabilities_ - eigen_probabilities).array()
+				/ eigen_probabilities.array()).abs().maxCoeff();
+		printf("%8d %16.2f %17.2f %9.2f %25g\n", num_rollouts, eigen_time * 1e6, exp_in_place_time * 1e6,
+				eigen_time / exp_in_place_time, difference);
+	}
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#ifndef EVALUATION_SETUP_H_
+#define EVALUATION_SETUP_H_
+
+#include <ros/ros.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <itomp_ca_planner/common.h>
+#include <itomp_ca_planner/model/itomp_robot_model.h>
+#include <itomp_ca_planner/trajectory/itomp_cio_trajectory.h>
+#include <itomp_ca_planner/optimization/evaluation_manager.h>
+#include <itomp_ca_planner/visualization/visualization_manager.h>
+#include <itomp_ca_planner/util/planning_parameters.h>
+#include <boost/scoped_ptr.hpp>
+#include <set>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Sets up an EvaluationManager the way ItompPlannerNode and ItompOptimizer do,
+ * for the tests and benchmarks. Needs robot_description and the itomp_planner parameters.
+ */
+class EvaluationSetup
+{
+public:
+	EvaluationSetup() : planning_group_(NULL), iteration_(0) {}
+
+	// min-jerk trajectory of the group from the zero configuration to the goal
+	bool initialize(const std::string& group_name, const std::vector<double>& goal)
+	{
+		PlanningParameters::getInstance()->initFromNodeHandle();
+
+		robot_model_loader::RobotModelLoader robot_model_loader("robot_description");
+		robot_model::RobotModelPtr kinematic_model = robot_model_loader.getModel();
+		if (!kinematic_model)
+		{
+			ROS_ERROR("Could not load the robot model from robot_description");
+			return false;
+		}
+		if (!robot_model_.init(kinematic_model, robot_model_loader.getRobotDescription()))
+			return false;
+		VisualizationManager::getInstance()->initialize(robot_model_);
+
+		planning_group_ = robot_model_.getPlanningGroup(group_name);
+		if (planning_group_ == NULL)
+		{
+			ROS_ERROR("Planning group %s is not in the robot model", group_name.c_str());
+			return false;
+		}
+		if ((int) goal.size() != planning_group_->num_joints_)
+		{
+			ROS_ERROR("Goal has %d joints, planning group %s has %d", (int) goal.size(), group_name.c_str(),
+					planning_group_->num_joints_);
+			return false;
+		}
+
+		planning_scene_.reset(new planning_scene::PlanningScene(kinematic_model));
+
+		full_trajectory_.reset(new ItompCIOTrajectory(&robot_model_,
+				PlanningParameters::getInstance()->getTrajectoryDuration(),
+				PlanningParameters::getInstance()->getTrajectoryDiscretization(),
+				PlanningParameters::getInstance()->getNumContacts(),
+				PlanningParameters::getInstance()->getPhaseDuration()));
+
+		std::set<int> groupJointsKDLIndices;
+		int goal_index = full_trajectory_->getNumPoints() - 1;
+		for (int i = 0; i < planning_group_->num_joints_; ++i)
+		{
+			int kdl_number = planning_group_->group_joints_[i].kdl_joint_index_;
+			groupJointsKDLIndices.insert(kdl_number);
+			(*full_trajectory_)(goal_index, kdl_number) = goal[i];
+		}
+		Eigen::MatrixXd start_derivatives = Eigen::MatrixXd::Zero(2, robot_model_.getNumKDLJoints());
+		full_trajectory_->fillInMinJerk(groupJointsKDLIndices, start_derivatives.row(0), start_derivatives.row(1));
+
+		group_trajectory_.reset(new ItompCIOTrajectory(*full_trajectory_, planning_group_, DIFF_RULE_LENGTH));
+
+		evaluation_manager_.reset(new EvaluationManager(&iteration_));
+		evaluation_manager_->initialize(full_trajectory_.get(), group_trajectory_.get(), &robot_model_,
+				planning_group_, 0.0, 0.0, moveit_msgs::Constraints(), planning_scene_);
+
+		return true;
+	}
+
+	// copies the changed free points of the group trajectory to the full trajectory
+	void updateTrajectory()
+	{
+		evaluation_manager_->handleJointLimits();
+		evaluation_manager_->updateFullTrajectory();
+	}
+
+	ItompRobotModel robot_model_;
+	const ItompPlanningGroup* planning_group_;
+	planning_scene::PlanningScenePtr planning_scene_;
+	boost::shared_ptr<ItompCIOTrajectory> full_trajectory_;
+	boost::shared_ptr<ItompCIOTrajectory> group_trajectory_;
+	int iteration_;
+	boost::scoped_ptr<EvaluationManager> evaluation_manager_;
+};
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+#ifndef RANDOM_TREE_H_
+#define RANDOM_TREE_H_
+
+#include <kdl/tree.hpp>
+#include <kdl/jntarray.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <sstream>
+#include <vector>
+
+namespace itomp_ca_planner
+{
+
+/**
+ * \brief Random KDL trees and joint values for the forward kinematics tests and benchmarks
+ * Revolute, prismatic and fixed joints with general axes, branching like a humanoid
+ */
+class RandomTree
+{
+public:
+	RandomTree(unsigned int seed) : rng_(seed), uniform_(rng_, boost::uniform_real<double>(-1.0, 1.0)) {}
+
+	// the segments are named segment_0 (the root) to segment_<num_segments - 1>
+	void build(KDL::Tree& tree, int num_segments)
+	{
+		tree = KDL::Tree("segment_0");
+		for (int i = 1; i < num_segments; ++i)
+		{
+			// mostly extends the last segment, sometimes branches from an earlier one
+			int parent = i - 1;
+			if (uniform_() > 0.7)
+				parent = boost::variate_generator<boost::mt19937&, boost::uniform_int<int> >(rng_,
+						boost::uniform_int<int>(0, i - 1))();
+
+			KDL::Vector origin(0.2 * uniform_(), 0.2 * uniform_(), 0.2 * uniform_());
+			KDL::Vector axis = randomAxis();
+			double type = uniform_();
+			KDL::Joint joint;
+			if (type < 0.5)
+				joint = KDL::Joint(name("joint_", i), origin, axis, KDL::Joint::RotAxis);
+			else if (type < 0.7)
+				joint = KDL::Joint(name("joint_", i), origin, axis, KDL::Joint::TransAxis);
+			else
+				joint = KDL::Joint(name("joint_", i), KDL::Joint::None);
+
+			KDL::Frame tip(KDL::Rotation::RPY(M_PI * uniform_(), M_PI * uniform_(), M_PI * uniform_()),
+					KDL::Vector(0.3 * uniform_(), 0.3 * uniform_(), 0.3 * uniform_()));
+			tree.addSegment(KDL::Segment(name("segment_", i), joint, tip), name("segment_", parent));
+		}
+	}
+
+	void randomize(KDL::JntArray& q)
+	{
+		for (unsigned int i = 0; i < q.rows(); ++i)
+			q(i) = M_PI * uniform_();
+	}
+
+	double uniform()
+	{
+		return uniform_();
+	}
+
+private:
+	KDL::Vector randomAxis()
+	{
+		KDL::Vector axis;
+		do
+		{
+			axis = KDL::Vector(uniform_(), uniform_(), uniform_());
+		} while (axis.Norm() < 0.1);
+		return axis / axis.Norm();
+	}
+
+	static std::string name(const char* prefix, int i)
+	{
+		std::ostringstream stream;
+		stream << prefix << i;
+		return stream.str();
+	}
+
+	boost::mt19937 rng_;
+	boost::variate_generator<boost::mt19937&, boost::uniform_real<double> > uniform_;
+};
+
+}
+
+#endif
@@ -0,0 +1,176 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+// TreeFkSolverJointPosAxisBatch against TreeFkSolverJointPosAxisPartial::JntToCartFull on random trees
+#include <gtest/gtest.h>
+#include <itomp_ca_planner/model/treefksolverjointposaxis_partial.hpp>
+#include <itomp_ca_planner/model/treefksolverjointposaxis_batch.hpp>
+#include "random_tree.h"
+
+using namespace itomp_ca_planner;
+
+namespace
+{
+const double TOLERANCE = 1e-12;
+// float rounding accumulates along chains of up to 35 segments
+const double FLOAT_TOLERANCE = 1e-5;
+
+struct FkOutputs
+{
+	std::vector<KDL::Vector> joint_pos_;
+	std::vector<KDL::Vector> joint_axis_;
+	std::vector<KDL::Frame> segment_frames_;
+};
+
+// runs the batch solver on all partial batches from 1 to batch_size points
+void expectBatchMatchesFull(bool use_avx2, bool single_precision, double tolerance)
+{
+	const int batch_size = single_precision ? KDL::TreeFkSolverJointPosAxisBatch::FLOAT_BATCH_SIZE
+			: KDL::TreeFkSolverJointPosAxisBatch::BATCH_SIZE;
+	for (unsigned int seed = 1; seed <= 10; ++seed)
+	{
+		SCOPED_TRACE(seed);
+		RandomTree random_tree(seed);
+		KDL::Tree tree;
+		random_tree.build(tree, 5 + 3 * seed);
+		int num_joints = tree.getNrOfJoints();
+		int num_segments = tree.getNrOfSegments() + 1;
+
+		KDL::TreeFkSolverJointPosAxisPartial solver(tree, "segment_0", std::vector<bool>(num_joints, true));
+		KDL::TreeFkSolverJointPosAxisBatch batch_solver(tree, "segment_0");
+		ASSERT_TRUE(batch_solver.isSupported());
+		if (!batch_solver.setUseAVX2(use_avx2))
+		{
+			printf("AVX2 is not supported by the CPU\n");
+			return;
+		}
+
+		for (int num_points = 1; num_points <= batch_size; ++num_points)
+		{
+			SCOPED_TRACE(num_points);
+			std::vector<KDL::JntArray> q(num_points, KDL::JntArray(num_joints));
+			std::vector<FkOutputs> batch(num_points);
+			std::vector<KDL::Vector*> joint_pos(num_points);
+			std::vector<KDL::Vector*> joint_axis(num_points);
+			std::vector<KDL::Frame*> segment_frames(num_points);
+			for (int p = 0; p < num_points; ++p)
+			{
+				random_tree.randomize(q[p]);
+				batch[p].joint_pos_.resize(num_joints);
+				batch[p].joint_axis_.resize(num_joints);
+				batch[p].segment_frames_.resize(num_segments);
+				joint_pos[p] = &batch[p].joint_pos_[0];
+				joint_axis[p] = &batch[p].joint_axis_[0];
+				segment_frames[p] = &batch[p].segment_frames_[0];
+			}
+			if (single_precision)
+				batch_solver.JntToCartFullFloat(&q[0], num_points, &joint_pos[0], &joint_axis[0], &segment_frames[0]);
+			else
+				batch_solver.JntToCartFull(&q[0], num_points, &joint_pos[0], &joint_axis[0], &segment_frames[0]);
+
+			for (int p = 0; p < num_points; ++p)
+			{
+				FkOutputs full;
+				solver.JntToCartFull(q[p], full.joint_pos_, full.joint_axis_, full.segment_frames_);
+				ASSERT_EQ(num_segments, (int) full.segment_frames_.size());
+				for (int i = 0; i < num_joints; ++i)
+				{
+					EXPECT_NEAR(0.0, (full.joint_pos_[i] - batch[p].joint_pos_[i]).Norm(), tolerance) << "joint " << i;
+					EXPECT_NEAR(0.0, (full.joint_axis_[i] - batch[p].joint_axis_[i]).Norm(), tolerance) << "joint " << i;
+				}
+				for (int i = 0; i < num_segments; ++i)
+				{
+					const KDL::Frame& e = full.segment_frames_[i];
+					const KDL::Frame& a = batch[p].segment_frames_[i];
+					EXPECT_NEAR(0.0, (e.p - a.p).Norm(), tolerance) << "segment " << i;
+					for (int r = 0; r < 3; ++r)
+						for (int c = 0; c < 3; ++c)
+							EXPECT_NEAR(e.M(r, c), a.M(r, c), tolerance) << "segment " << i;
+				}
+			}
+		}
+	}
+}
+}
+
+TEST(TreeFkSolverJointPosAxisBatch, GenericKernelMatchesFull)
+{
+	expectBatchMatchesFull(false, false, TOLERANCE);
+}
+
+TEST(TreeFkSolverJointPosAxisBatch, GenericFloatKernelMatchesFull)
+{
+	expectBatchMatchesFull(false, true, FLOAT_TOLERANCE);
+}
+
+TEST(TreeFkSolverJointPosAxisBatch, AVX2KernelMatchesFull)
+{
+	expectBatchMatchesFull(true, false, TOLERANCE);
+}
+
+TEST(TreeFkSolverJointPosAxisBatch, AVX2FloatKernelMatchesFull)
+{
+	expectBatchMatchesFull(true, true, FLOAT_TOLERANCE);
+}
+
+TEST(TreeFkSolverJointPosAxisBatch, MovingReferenceFrameIsNotSupported)
+{
+	RandomTree random_tree(1);
+	KDL::Tree tree;
+	random_tree.build(tree, 20);
+	KDL::TreeFkSolverJointPosAxisPartial solver(tree, "segment_0", std::vector<bool>(tree.getNrOfJoints(), true));
+
+	// the first segment below a joint
+	std::vector<int> ancestor_joints;
+	int segment_nr = 1;
+	for (; segment_nr < solver.getNumSegments(); ++segment_nr)
+	{
+		solver.getAncestorJoints(segment_nr, ancestor_joints);
+		if (!ancestor_joints.empty())
+			break;
+	}
+	ASSERT_LT(segment_nr, solver.getNumSegments());
+
+	KDL::TreeFkSolverJointPosAxisBatch batch_solver(tree, solver.getSegmentNames()[segment_nr]);
+	EXPECT_FALSE(batch_solver.isSupported());
+}
+
+int main(int argc, char** argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
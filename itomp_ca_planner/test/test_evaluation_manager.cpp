@@ -0,0 +1,169 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+// EvaluationManager on the 7-DOF test arm, with a box in front of it. Run by test_evaluation_manager.test.
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <geometric_shapes/shapes.h>
+#include <cmath>
+#include <itomp_ca_planner/cost/signed_distance_field.h>
+#include <itomp_ca_planner/util/allocation_counter.h>
+#include "evaluation_setup.h"
+
+using namespace itomp_ca_planner;
+
+namespace
+{
+EvaluationSetup* setup = NULL;
+
+// moves the free points of the group trajectory and copies them to the full trajectory
+void perturbTrajectory(double amplitude)
+{
+	Eigen::Block<Eigen::MatrixXd, Eigen::Dynamic, Eigen::Dynamic> free_points =
+			setup->group_trajectory_->getFreeTrajectoryBlock();
+	for (int i = 0; i < free_points.rows(); ++i)
+		for (int j = 0; j < free_points.cols(); ++j)
+			free_points(i, j) += amplitude * std::sin(1.0 + i + 3.0 * j);
+	setup->updateTrajectory();
+}
+}
+
+TEST(EvaluationManager, SteadyStateEvaluationDoesNotAllocate)
+{
+	long count_start = getHeapAllocationCount();
+	delete new int;
+	if (getHeapAllocationCount() == count_start)
+	{
+		printf("Heap allocations are not counted, build with -DITOMP_COUNT_HEAP_ALLOCATIONS=ON\n");
+		return;
+	}
+
+	EvaluationManager& evaluation_manager = *setup->evaluation_manager_;
+
+	// the first evaluations size the buffers
+	evaluation_manager.evaluate();
+	perturbTrajectory(0.01);
+	evaluation_manager.evaluate();
+
+	for (int n = 0; n < 5; ++n)
+	{
+		perturbTrajectory(0.01);
+		evaluation_manager.evaluate();
+		EXPECT_EQ(0, evaluation_manager.getLastEvaluationAllocationCount()) << "evaluation " << n;
+	}
+}
+
+TEST(EvaluationManager, GradientMatchesFiniteDifferences)
+{
+	EvaluationManager& evaluation_manager = *setup->evaluation_manager_;
+
+	Eigen::MatrixXd gradient;
+	evaluation_manager.evaluateGradient(gradient);
+	EXPECT_FALSE(evaluation_manager.isLastTrajectoryFeasible()) << "the trajectory should penetrate the box";
+
+	Eigen::Block<Eigen::MatrixXd, Eigen::Dynamic, Eigen::Dynamic> free_points =
+			setup->group_trajectory_->getFreeTrajectoryBlock();
+	ASSERT_EQ(free_points.rows(), gradient.rows());
+	ASSERT_EQ(free_points.cols(), gradient.cols());
+
+	const double step = 1e-6;
+	Eigen::MatrixXd numerical_gradient(gradient.rows(), gradient.cols());
+	for (int i = 0; i < free_points.rows(); ++i)
+	{
+		for (int j = 0; j < free_points.cols(); ++j)
+		{
+			double value = free_points(i, j);
+			free_points(i, j) = value + step;
+			setup->updateTrajectory();
+			double cost_plus = evaluation_manager.evaluate();
+			free_points(i, j) = value - step;
+			setup->updateTrajectory();
+			double cost_minus = evaluation_manager.evaluate();
+			free_points(i, j) = value;
+			numerical_gradient(i, j) = (cost_plus - cost_minus) / (2.0 * step);
+		}
+	}
+	setup->updateTrajectory();
+
+	// the trilinear distance field is only piecewise smooth, so the error is measured over the whole gradient
+	ASSERT_GT(numerical_gradient.norm(), 0.0);
+	EXPECT_LT((gradient - numerical_gradient).norm(), 1e-2 * numerical_gradient.norm());
+}
+
+TEST(EvaluationManager, DoubleEvaluationAfterFloatMatchesFreshEvaluation)
+{
+	EvaluationManager& evaluation_manager = *setup->evaluation_manager_;
+
+	perturbTrajectory(0.02);
+	evaluation_manager.setSinglePrecision(true);
+	evaluation_manager.evaluate();
+	evaluation_manager.setSinglePrecision(false);
+	double cost = evaluation_manager.evaluate();
+
+	// a new manager has no cached frames
+	EvaluationManager fresh_evaluation_manager(&setup->iteration_);
+	fresh_evaluation_manager.initialize(setup->full_trajectory_.get(), setup->group_trajectory_.get(),
+			&setup->robot_model_, setup->planning_group_, 0.0, 0.0, moveit_msgs::Constraints(), setup->planning_scene_);
+	double fresh_cost = fresh_evaluation_manager.evaluate();
+
+	EXPECT_EQ(fresh_cost, cost);
+	EXPECT_EQ(fresh_evaluation_manager.isLastTrajectoryFeasible(), evaluation_manager.isLastTrajectoryFeasible());
+}
+
+int main(int argc, char** argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	ros::init(argc, argv, "test_evaluation_manager");
+	ros::NodeHandle node_handle;
+
+	static const double goal_array[] = { 1.0, 0.8, 0.0, 1.0, 0.0, 0.5, 0.0 };
+	std::vector<double> goal(goal_array, goal_array + 7);
+
+	EvaluationSetup evaluation_setup;
+	if (!evaluation_setup.initialize("arm", goal))
+		return 1;
+
+	// the middle of the trajectory penetrates the box, the points before and after it pass within the clearance
+	shapes::ShapeConstPtr box(new shapes::Box(0.2, 0.2, 0.2));
+	Eigen::Affine3d box_pose = Eigen::Affine3d::Identity();
+	box_pose.translation() = Eigen::Vector3d(0.32, 0.1, 0.95);
+	evaluation_setup.planning_scene_->getWorldNonConst()->addToObject("box", box, box_pose);
+	SignedDistanceField::getInstance()->initialize(evaluation_setup.planning_scene_, evaluation_setup.robot_model_);
+
+	setup = &evaluation_setup;
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,158 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+// TreeFkSolverJointPosAxisPartial::JntToCartPartial against JntToCartFull on random trees
+#include <gtest/gtest.h>
+#include <itomp_ca_planner/model/treefksolverjointposaxis_partial.hpp>
+#include <limits>
+#include "random_tree.h"
+
+using namespace itomp_ca_planner;
+
+namespace
+{
+const double TOLERANCE = 1e-12;
+
+struct FkOutputs
+{
+	std::vector<KDL::Vector> joint_pos_;
+	std::vector<KDL::Vector> joint_axis_;
+	std::vector<KDL::Frame> segment_frames_;
+};
+
+void expectNear(const FkOutputs& expected, const FkOutputs& actual)
+{
+	ASSERT_EQ(expected.joint_pos_.size(), actual.joint_pos_.size());
+	ASSERT_EQ(expected.segment_frames_.size(), actual.segment_frames_.size());
+	for (std::size_t i = 0; i < expected.joint_pos_.size(); ++i)
+	{
+		EXPECT_NEAR(0.0, (expected.joint_pos_[i] - actual.joint_pos_[i]).Norm(), TOLERANCE) << "joint " << i;
+		EXPECT_NEAR(0.0, (expected.joint_axis_[i] - actual.joint_axis_[i]).Norm(), TOLERANCE) << "joint " << i;
+	}
+	for (std::size_t i = 0; i < expected.segment_frames_.size(); ++i)
+	{
+		const KDL::Frame& e = expected.segment_frames_[i];
+		const KDL::Frame& a = actual.segment_frames_[i];
+		EXPECT_NEAR(0.0, (e.p - a.p).Norm(), TOLERANCE) << "segment " << i;
+		for (int r = 0; r < 3; ++r)
+			for (int c = 0; c < 3; ++c)
+				EXPECT_NEAR(e.M(r, c), a.M(r, c), TOLERANCE) << "segment " << i;
+	}
+}
+}
+
+TEST(TreeFkSolverJointPosAxisPartial, PartialMatchesFullForChangedActiveJoints)
+{
+	for (unsigned int seed = 1; seed <= 20; ++seed)
+	{
+		SCOPED_TRACE(seed);
+		RandomTree random_tree(seed);
+		KDL::Tree tree;
+		random_tree.build(tree, 5 + 2 * seed);
+		int num_joints = tree.getNrOfJoints();
+
+		std::vector<bool> active_joints(num_joints);
+		for (int j = 0; j < num_joints; ++j)
+			active_joints[j] = (random_tree.uniform() > -0.2); // about 60%
+		KDL::TreeFkSolverJointPosAxisPartial solver(tree, "segment_0", active_joints);
+
+		KDL::JntArray q(num_joints);
+		random_tree.randomize(q);
+		FkOutputs partial;
+		solver.JntToCartFull(q, partial.joint_pos_, partial.joint_axis_, partial.segment_frames_);
+		KDL::JntArray q_cached = q;
+
+		// consecutive partial updates of the same outputs, as in the evaluation of a changing trajectory
+		for (int step = 0; step < 10; ++step)
+		{
+			for (int j = 0; j < num_joints; ++j)
+			{
+				if (active_joints[j] && random_tree.uniform() > 0.4)
+					q(j) += random_tree.uniform();
+			}
+			solver.JntToCartPartial(q, q_cached.data.data(), partial.joint_pos_, partial.joint_axis_,
+					partial.segment_frames_);
+			q_cached = q;
+
+			FkOutputs full;
+			solver.JntToCartFull(q, full.joint_pos_, full.joint_axis_, full.segment_frames_);
+			expectNear(full, partial);
+		}
+	}
+}
+
+TEST(TreeFkSolverJointPosAxisPartial, PartialFallsBackToFull)
+{
+	RandomTree random_tree(100);
+	KDL::Tree tree;
+	random_tree.build(tree, 30);
+	int num_joints = tree.getNrOfJoints();
+	ASSERT_GT(num_joints, 1);
+
+	std::vector<bool> active_joints(num_joints, true);
+	active_joints[num_joints - 1] = false;
+	KDL::TreeFkSolverJointPosAxisPartial solver(tree, "segment_0", active_joints);
+
+	KDL::JntArray q(num_joints);
+	random_tree.randomize(q);
+	FkOutputs full;
+	solver.JntToCartFull(q, full.joint_pos_, full.joint_axis_, full.segment_frames_);
+
+	// unknown cached values
+	FkOutputs partial = full;
+	KDL::JntArray q_new = q;
+	q_new(0) += 0.5;
+	std::vector<double> unknown(num_joints, std::numeric_limits<double>::quiet_NaN());
+	solver.JntToCartPartial(q_new, &unknown[0], partial.joint_pos_, partial.joint_axis_, partial.segment_frames_);
+	FkOutputs expected;
+	solver.JntToCartFull(q_new, expected.joint_pos_, expected.joint_axis_, expected.segment_frames_);
+	expectNear(expected, partial);
+
+	// a changed inactive joint
+	partial = full;
+	q_new = q;
+	q_new(num_joints - 1) += 0.5;
+	solver.JntToCartPartial(q_new, q.data.data(), partial.joint_pos_, partial.joint_axis_, partial.segment_frames_);
+	solver.JntToCartFull(q_new, expected.joint_pos_, expected.joint_axis_, expected.segment_frames_);
+	expectNear(expected, partial);
+}
+
+int main(int argc, char** argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
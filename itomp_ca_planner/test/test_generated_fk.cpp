@@ -0,0 +1,132 @@
+/*
+
+License
+
+ITOMP Optimization-based Planner
+Copyright © and trademark ™ 2014 University of North Carolina at Chapel Hill.
+All rights reserved.
+
+Permission to use, copy, modify, and distribute this software and its documentation
+for educational, research, and non-profit purposes, without fee, and without a
+written agreement is hereby granted, provided that the above copyright notice,
+this paragraph, and the following four paragraphs appear in all copies.
+
+This software program and documentation are copyrighted by the University of North
+Carolina at Chapel Hill. The software program and documentation are supplied "as is,"
+without any accompanying services from the University of North Carolina at Chapel
+Hill or the authors. The University of North Carolina at Chapel Hill and the
+authors do not warrant that the operation of the program will be uninterrupted
+or error-free. The end-user understands that the program was developed for research
+purposes and is advised not to rely exclusively on the program for any reason.
+
+IN NO EVENT SHALL THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE AUTHORS
+BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+DAMAGES, INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+DOCUMENTATION, EVEN IF THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL OR THE
+AUTHORS HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS SPECIFICALLY
+DISCLAIM ANY WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE AND ANY STATUTORY WARRANTY
+OF NON-INFRINGEMENT. THE SOFTWARE PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND
+THE UNIVERSITY OF NORTH CAROLINA AT CHAPEL HILL AND THE AUTHORS HAVE NO OBLIGATIONS
+TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+
+Any questions or comments should be sent to the author chpark@cs.unc.edu
+
+*/
+// The forward kinematics generated from test/test_arm.urdf at build time against the KDL tree of the same URDF
+#include <gtest/gtest.h>
+#include <kdl_parser/kdl_parser.hpp>
+#include <itomp_ca_planner/model/generated_fk.h>
+#include <itomp_ca_planner/model/treefksolverjointposaxis_partial.hpp>
+#include "random_tree.h"
+
+using namespace itomp_ca_planner;
+
+namespace
+{
+const double TOLERANCE = 1e-9;
+
+class GeneratedFkTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		generated_fk_ = findGeneratedFk("test_arm");
+		ASSERT_TRUE(generated_fk_ != NULL) << "the generated source of test_arm.urdf is not linked";
+		ASSERT_TRUE(kdl_parser::treeFromFile(TEST_ARM_URDF, tree_));
+		num_joints_ = tree_.getNrOfJoints();
+	}
+
+	const GeneratedFk* generated_fk_;
+	KDL::Tree tree_;
+	int num_joints_;
+};
+
+void expectEqualFk(const std::vector<KDL::Vector>& joint_pos, const std::vector<KDL::Vector>& joint_axis,
+		const std::vector<KDL::Frame>& segment_frames, const std::vector<KDL::Vector>& expected_joint_pos,
+		const std::vector<KDL::Vector>& expected_joint_axis, const std::vector<KDL::Frame>& expected_segment_frames)
+{
+	for (std::size_t j = 0; j < joint_pos.size(); ++j)
+	{
+		EXPECT_TRUE(KDL::Equal(expected_joint_pos[j], joint_pos[j], TOLERANCE)) << "joint " << j;
+		EXPECT_TRUE(KDL::Equal(expected_joint_axis[j], joint_axis[j], TOLERANCE)) << "joint " << j;
+	}
+	for (std::size_t i = 0; i < segment_frames.size(); ++i)
+		EXPECT_TRUE(KDL::Equal(expected_segment_frames[i], segment_frames[i], TOLERANCE)) << "segment " << i;
+}
+}
+
+TEST_F(GeneratedFkTest, SegmentsMatchKdlTree)
+{
+	KDL::TreeFkSolverJointPosAxisPartial solver(tree_, tree_.getRootSegment()->first,
+			std::vector<bool>(num_joints_, true));
+	ASSERT_EQ(solver.getNumJoints(), generated_fk_->num_joints_);
+	ASSERT_EQ(solver.getNumSegments(), generated_fk_->num_segments_);
+
+	const std::vector<std::string> segment_names = solver.getSegmentNames();
+	for (int i = 0; i < generated_fk_->num_segments_; ++i)
+		EXPECT_EQ(segment_names[i], generated_fk_->segment_names_[i]) << "segment " << i;
+}
+
+TEST_F(GeneratedFkTest, OutputsMatchKdl)
+{
+	KDL::TreeFkSolverJointPosAxisPartial solver(tree_, tree_.getRootSegment()->first,
+			std::vector<bool>(num_joints_, true));
+	int num_segments = solver.getNumSegments();
+	ASSERT_EQ(num_segments, generated_fk_->num_segments_);
+
+	std::vector<KDL::Vector> joint_pos, joint_axis;
+	std::vector<KDL::Frame> segment_frames;
+	std::vector<KDL::Vector> generated_joint_pos(num_joints_), generated_joint_axis(num_joints_);
+	std::vector<KDL::Frame> generated_segment_frames(num_segments);
+
+	RandomTree random(1);
+	KDL::JntArray q(num_joints_);
+	for (int trial = 0; trial < 100; ++trial)
+	{
+		SCOPED_TRACE(trial);
+		random.randomize(q);
+		solver.JntToCartFull(q, joint_pos, joint_axis, segment_frames);
+		generated_fk_->function_(q.data.data(), &generated_joint_pos[0], &generated_joint_axis[0],
+				&generated_segment_frames[0]);
+		expectEqualFk(generated_joint_pos, generated_joint_axis, generated_segment_frames, joint_pos, joint_axis,
+				segment_frames);
+	}
+
+	// the solver uses the generated function once it is set
+	ASSERT_TRUE(solver.setUnrolledFk(generated_fk_->function_));
+	random.randomize(q);
+	solver.JntToCartFull(q, joint_pos, joint_axis, segment_frames);
+	generated_fk_->function_(q.data.data(), &generated_joint_pos[0], &generated_joint_axis[0],
+			&generated_segment_frames[0]);
+	expectEqualFk(joint_pos, joint_axis, segment_frames, generated_joint_pos, generated_joint_axis,
+			generated_segment_frames);
+}
+
+int main(int argc, char** argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}